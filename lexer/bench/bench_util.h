@@ -0,0 +1,77 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Helpers shared by the benchmarks and the differential test
+
+// Size of a static C-style array. Don't use on pointers!
+#define ARRAYSIZE(_ARR)             ((int)(sizeof(_ARR) / sizeof(*(_ARR))))
+
+// Names to look up, roughly the mix of a COOL source: mostly identifiers and types, some keywords
+#define BENCH_WORDS                 {"class", "Main", "inherits", "IO", "main", "self", "x", "out_string",       \
+                                     "let", "in", "if", "then", "else", "fi", "while", "loop", "pool",          \
+                                     "Int", "String", "Bool", "SELF_TYPE", "new", "isvoid", "counter",          \
+                                     "case", "of", "esac", "not", "true", "false", "tRUE", "iNHERITS",          \
+                                     "abort", "type_name", "length", "concat", "substr", "in_int", "i", "ifx"}
+
+static inline double elapsed_seconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static inline double elapsed_ns(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// qsort comparator for doubles, in increasing order
+static inline int compare_doubles(const void* a, const void* b) {
+    double value_a = *(const double*)a;
+    double value_b = *(const double*)b;
+
+    return (value_a > value_b) - (value_a < value_b);
+}
+
+/**
+ * @brief Reads the whole file into memory.
+ * 
+ * @param filename File to read.
+ * @param size Receives the file size.
+ * @return Allocated contents, or NULL on error.
+ */
+static inline char* read_whole_file(const char* filename, size_t* size) {
+    FILE* fp = fopen(filename, "rb");
+
+    if (fp == NULL)
+        return NULL;
+
+    size_t capacity = 64 * 1024;
+    char* data = malloc(capacity);
+    *size = 0;
+
+    while (data != NULL) {
+        *size += fread(data + *size, 1, capacity - *size, fp);
+
+        if (*size < capacity)
+            break;
+
+        capacity *= 2;
+        char* bigger = realloc(data, capacity);
+
+        if (bigger == NULL)
+            free(data);
+
+        data = bigger;
+    }
+
+    if (ferror(fp)) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(fp);
+    return data;
+}
+
+#endif
@@ -0,0 +1,364 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "lexer.h"
+
+// Defaults
+#define CORPUS_DEFAULT_SIZE         (16 * 1024 * 1024)
+#define CORPUS_DEFAULT_SEED         1
+#define CORPUS_MAX_STRING_SIZE      200     // Well under LITERAL_STRING_MAX_SIZE
+#define CORPUS_MAX_COMMENT_DEPTH    5
+
+// Kinds of statement, each mix gives them a weight
+#define STATEMENT_NAMES             0
+#define STATEMENT_STRING            1
+#define STATEMENT_COMMENT           2
+#define STATEMENT_INTEGER           3
+#define STATEMENT_KIND_COUNT        4
+
+/**
+ * @brief Mix struct.
+ * Named token mix: how often each kind of statement is picked.
+ * 
+ */
+typedef struct Mix {
+    const char* name;
+    unsigned weights[STATEMENT_KIND_COUNT];
+} Mix;
+
+static const Mix mixes[] = {
+    {"mixed",       {60, 15, 15, 10}},
+    {"identifiers", {90, 3, 4, 3}},
+    {"strings",     {15, 75, 5, 5}},
+    {"comments",    {15, 5, 75, 5}},
+    {"integers",    {20, 5, 5, 70}},
+};
+
+static const char* identifiers[] = {"self", "x", "y", "i", "count", "result", "node", "next_node", "value",
+                                    "out_string", "out_int", "in_int", "length", "concat", "substr", "abort",
+                                    "type_name", "copy", "list_head", "tail_of_list", "accumulator", "index2"};
+
+static const char* types[] = {"Int", "String", "Bool", "IO", "Object", "SELF_TYPE", "Main", "List", "Cons",
+                              "Node", "LinkedList", "Counter2"};
+
+static const char* words[] = {"the", "lexer", "reads", "tokens", "from", "a", "COOL", "source", "and", "writes",
+                              "them", "out", "one", "per", "line", "with", "their", "kind", "text", "number"};
+
+/**
+ * @brief Generator struct.
+ * State of one corpus: the output, the PRNG and the weights in use.
+ * escaped_newlines lets strings go on over several lines, the reference lexer rejects them.
+ * 
+ */
+typedef struct Generator {
+    FILE* out;
+    uint64_t state;
+    unsigned weights[STATEMENT_KIND_COUNT];
+    unsigned total_weight;
+    int escaped_newlines;
+    size_t size;
+} Generator;
+
+/**
+ * @brief Next number of the xorshift64* generator, so the corpus only depends on the seed.
+ * 
+ */
+static uint64_t next_random(Generator* generator) {
+    generator->state ^= generator->state >> 12;
+    generator->state ^= generator->state << 25;
+    generator->state ^= generator->state >> 27;
+    return generator->state * 0x2545F4914F6CDD1DULL;
+}
+
+static unsigned random_below(Generator* generator, unsigned limit) {
+    return (unsigned)((next_random(generator) >> 32) % limit);
+}
+
+static void emit(Generator* generator, const char* text) {
+    size_t size = strlen(text);
+
+    fwrite(text, 1, size, generator->out);
+    generator->size += size;
+}
+
+__attribute__((format(printf, 2, 3)))
+static void emit_format(Generator* generator, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    int size = vfprintf(generator->out, format, args);
+
+    va_end(args);
+    generator->size += size > 0 ? size : 0;
+}
+
+static const char* pick(Generator* generator, const char* const* choices, int count) {
+    return choices[random_below(generator, count)];
+}
+
+#define PICK(_GENERATOR, _CHOICES)  pick((_GENERATOR), (_CHOICES), ARRAYSIZE(_CHOICES))
+
+/**
+ * @brief Writes an assignment, call or control statement made of names, keywords and terminals.
+ * 
+ */
+static void emit_names(Generator* generator) {
+    const char* a = PICK(generator, identifiers);
+    const char* b = PICK(generator, identifiers);
+    const char* type = PICK(generator, types);
+
+    switch (random_below(generator, 6)) {
+    case 0:
+        emit_format(generator, "        %s <- %s.%s(%s, %s);\n", a, b, PICK(generator, identifiers), a, b);
+        break;
+    case 1:
+        emit_format(generator, "        let %s : %s <- new %s in %s@%s.%s();\n", a, type, type, a, type, b);
+        break;
+    case 2:
+        emit_format(generator, "        if %s <= %s then %s else not %s fi;\n", a, b, a, b);
+        break;
+    case 3:
+        emit_format(generator, "        while isvoid %s = false loop %s <- ~%s pool;\n", a, b, b);
+        break;
+    case 4:
+        emit_format(generator, "        case %s of %s : %s => true; esac;\n", a, b, type);
+        break;
+    default:
+        emit_format(generator, "        { %s; %s; (%s); };\n", a, b, a);
+        break;
+    }
+}
+
+/**
+ * @brief Writes a call with a string literal. Literals stay short and never end in a backslash.
+ * With escaped_newlines some go on over several lines, so chunks may begin inside them.
+ * 
+ */
+static void emit_string(Generator* generator) {
+    char literal[CORPUS_MAX_STRING_SIZE + 8];
+    size_t size = 0;
+    size_t target = 1 + random_below(generator, CORPUS_MAX_STRING_SIZE);
+
+    while (size < target) {
+        const char* word = PICK(generator, words);
+        size_t word_size = strlen(word);
+
+        if (size + word_size + 2 > CORPUS_MAX_STRING_SIZE)
+            break;
+
+        memcpy(literal + size, word, word_size);
+        size += word_size;
+
+        // Escapes, always followed by a plain char
+        unsigned separator = random_below(generator, 16);
+        const char* escape = " ";
+
+        if (separator == 0)
+            escape = "\\n";
+        else if (separator == 1)
+            escape = "\\t";
+        else if (separator == 2 && generator->escaped_newlines)
+            escape = "\\\n";
+
+        memcpy(literal + size, escape, strlen(escape));
+        size += strlen(escape);
+    }
+
+    literal[size++] = '.';
+    literal[size] = '\0';
+
+    emit_format(generator, "        out_string(\"%s\");\n", literal);
+}
+
+/**
+ * @brief Writes a (* *) comment over several lines with depth - 1 comments nested in it, one per level,
+ * so some lines begin deeper than one level.
+ * 
+ */
+static void emit_nested_comment(Generator* generator, unsigned depth) {
+    emit_format(generator, "(* %s %s\n", PICK(generator, words), PICK(generator, words));
+
+    if (depth > 1) {
+        emit(generator, "   ");
+        emit_nested_comment(generator, depth - 1);
+        emit(generator, "\n");
+    }
+
+    emit_format(generator, "   %s *)", PICK(generator, words));
+}
+
+/**
+ * @brief Writes a -- comment or a (* *) comment, sometimes nested and over several lines.
+ * 
+ */
+static void emit_comment(Generator* generator) {
+    switch (random_below(generator, 4)) {
+    case 0:
+        emit_format(generator, "        -- %s %s %s %s\n", PICK(generator, words), PICK(generator, words),
+                    PICK(generator, words), PICK(generator, words));
+        break;
+    case 1:
+        emit_format(generator, "        (* %s %s *) %s;\n", PICK(generator, words), PICK(generator, words),
+                    PICK(generator, identifiers));
+        break;
+    case 2:
+        emit_format(generator, "        (* %s %s\n           (* %s %s *) %s\n           %s *)\n", PICK(generator, words),
+                    PICK(generator, words), PICK(generator, words), PICK(generator, words), PICK(generator, words),
+                    PICK(generator, words));
+        break;
+    default:
+        emit(generator, "        ");
+        emit_nested_comment(generator, 2 + random_below(generator, CORPUS_MAX_COMMENT_DEPTH - 1));
+        emit(generator, "\n");
+        break;
+    }
+}
+
+/**
+ * @brief Writes arithmetic on integer literals, all of them valid 32-bit integers.
+ * 
+ */
+static void emit_integer(Generator* generator) {
+    uint32_t a = random_below(generator, 100);
+    uint32_t b = random_below(generator, 100000);
+    uint32_t c = (uint32_t)(next_random(generator) >> 33);
+
+    emit_format(generator, "        %s <- %u * %u + %u - 0;\n", PICK(generator, identifiers), a, b, c);
+}
+
+static void emit_statement(Generator* generator) {
+    unsigned choice = random_below(generator, generator->total_weight);
+    int kind = 0;
+
+    while (choice >= generator->weights[kind])
+        choice -= generator->weights[kind++];
+
+    switch (kind) {
+    case STATEMENT_NAMES:
+        emit_names(generator);
+        break;
+    case STATEMENT_STRING:
+        emit_string(generator);
+        break;
+    case STATEMENT_COMMENT:
+        emit_comment(generator);
+        break;
+    default:
+        emit_integer(generator);
+        break;
+    }
+}
+
+/**
+ * @brief Writes classes of methods until the corpus reaches size bytes.
+ * 
+ */
+static void generate(Generator* generator, size_t size) {
+    for (unsigned class_index = 0; generator->size < size; class_index++) {
+        emit_format(generator, "class %s%u inherits %s {\n", PICK(generator, types), class_index, PICK(generator, types));
+
+        for (unsigned method = 0; method < 8 && generator->size < size; method++) {
+            emit_format(generator, "    %s%u(%s : %s) : %s {\n", PICK(generator, identifiers), method,
+                        PICK(generator, identifiers), PICK(generator, types), PICK(generator, types));
+            emit(generator, "    {\n");
+
+            for (unsigned statement = 0; statement < 16 && generator->size < size; statement++)
+                emit_statement(generator);
+
+            emit(generator, "    }\n    };\n");
+        }
+
+        emit(generator, "};\n\n");
+    }
+}
+
+/**
+ * @brief Parses "a,b,c,d" into the four statement weights.
+ * 
+ * @return 1 on success, 0 if malformed or all zero.
+ */
+static int parse_weights(const char* text, unsigned weights[STATEMENT_KIND_COUNT]) {
+    unsigned total = 0;
+
+    for (int i = 0; i < STATEMENT_KIND_COUNT; i++) {
+        char* end;
+        unsigned long weight = strtoul(text, &end, 10);
+
+        if (end == text || weight > 1000 || *end != (i + 1 < STATEMENT_KIND_COUNT ? ',' : '\0'))
+            return 0;
+
+        weights[i] = weight;
+        total += weight;
+        text = end + 1;
+    }
+
+    return total > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Generator generator = {.state = CORPUS_DEFAULT_SEED};
+    size_t size = CORPUS_DEFAULT_SIZE;
+    const char* filename = NULL;
+    int ok = 1;
+
+    memcpy(generator.weights, mixes[0].weights, sizeof(generator.weights));
+
+    for (int i = 1; i < argc && ok; i++) {
+        if (strncmp(argv[i], "--mix=", 6) == 0) {
+            ok = 0;
+
+            for (int m = 0; m < ARRAYSIZE(mixes); m++) {
+                if (strcmp(argv[i] + 6, mixes[m].name) == 0) {
+                    memcpy(generator.weights, mixes[m].weights, sizeof(generator.weights));
+                    ok = 1;
+                }
+            }
+        } else if (strncmp(argv[i], "--weights=", 10) == 0) {
+            ok = parse_weights(argv[i] + 10, generator.weights);
+        } else if (strcmp(argv[i], "--escaped-newlines") == 0) {
+            generator.escaped_newlines = 1;
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            char* end;
+            size = strtoull(argv[i] + 7, &end, 10);
+            ok = *end == '\0' && size > 0;
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            char* end;
+            generator.state = strtoull(argv[i] + 7, &end, 10);
+            ok = *end == '\0' && generator.state != 0;
+        } else if (filename == NULL && argv[i][0] != '-') {
+            filename = argv[i];
+        } else {
+            ok = 0;
+        }
+    }
+
+    if (!ok || filename == NULL) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [--mix=mixed|identifiers|strings|comments|integers] "
+               "[--weights=names,strings,comments,integers] [--escaped-newlines] [--size=bytes] [--seed=n] [output file]\n",
+               argv[0]);
+        return LEXER_ERROR_INCORRECT_USAGE;
+    }
+
+    for (int i = 0; i < STATEMENT_KIND_COUNT; i++)
+        generator.total_weight += generator.weights[i];
+
+    generator.out = fopen(filename, "wb");
+
+    if (generator.out == NULL) {
+        printf("\33[31mERROR:\33[0m could not open output file %s\n", filename);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    generate(&generator, size);
+
+    if (fclose(generator.out) != 0) {
+        printf("\33[31mERROR:\33[0m could not write output file %s\n", filename);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    return LEXER_OK;
+}
@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "lexer.h"
+#include "token.h"
+
+#define DIFF_ROUNDS     3
+
+// Chunked runs checked against the serial output. The small chunks cut through most strings and comments
+static char* const split_options[][2] = {
+    {"-j4", "--split=64"},
+    {"-j4", "--split=4096"},
+};
+
+/**
+ * @brief TokenText struct.
+ * One token of a -lex file, as the three (or two) lines it's written on.
+ * 
+ */
+typedef struct TokenText {
+    const char* line;
+    size_t line_size;
+    const char* kind;
+    size_t kind_size;
+    const char* text;
+    size_t text_size;
+} TokenText;
+
+/**
+ * @brief LexFile struct.
+ * Whole -lex file in memory and the position of the next token in it.
+ * 
+ */
+typedef struct LexFile {
+    char* data;
+    size_t size;
+    size_t position;
+} LexFile;
+
+/**
+ * @brief Copies the input, so the reference lexer writes its -lex file next to the copy and not over ours.
+ * 
+ * @return 1 on success, 0 on error.
+ */
+int copy_file(const char* from, const char* to) {
+    size_t size;
+    char* data = read_whole_file(from, &size);
+
+    if (data == NULL)
+        return 0;
+
+    FILE* fp = fopen(to, "wb");
+    int ok = fp != NULL && fwrite(data, 1, size, fp) == size;
+
+    if (fp != NULL && fclose(fp) != 0)
+        ok = 0;
+
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Runs the program and waits for it, with its output thrown away.
+ * 
+ * @param argv Program and its arguments, NULL terminated.
+ * @param seconds Receives the wall time from start to exit.
+ * @return 1 if the program ran to its end, 0 if it couldn't be started or was killed.
+ */
+int run_timed(char* const argv[], double* seconds) {
+    struct timespec start, end;
+
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t pid = fork();
+
+    if (pid < 0)
+        return 0;
+
+    if (pid == 0) {
+        // The reference lexer recurses once per token and overflows the default stack on big inputs
+        struct rlimit stack;
+
+        if (getrlimit(RLIMIT_STACK, &stack) == 0) {
+            stack.rlim_cur = stack.rlim_max;
+            setrlimit(RLIMIT_STACK, &stack);
+        }
+
+        // Diagnostics would only repeat what the comparison reports
+        if (freopen("/dev/null", "w", stdout) == NULL || freopen("/dev/null", "w", stderr) == NULL)
+            _exit(127);
+
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    int status;
+
+    if (waitpid(pid, &status, 0) != pid)
+        return 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *seconds = elapsed_seconds(start, end);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) != 127;
+}
+
+/**
+ * @brief Runs the program DIFF_ROUNDS times.
+ * 
+ * @return Median wall time, or a negative number if a run failed.
+ */
+double run_median(char* const argv[]) {
+    double rounds[DIFF_ROUNDS];
+
+    for (int i = 0; i < DIFF_ROUNDS; i++)
+        if (!run_timed(argv, &rounds[i]))
+            return -1;
+
+    qsort(rounds, DIFF_ROUNDS, sizeof(double), compare_doubles);
+    return rounds[DIFF_ROUNDS / 2];
+}
+
+/**
+ * @brief Reads the next line of the file, without its '\n'.
+ * 
+ * @return 1 if there was a line, 0 at the end of the file.
+ */
+static int next_line(LexFile* file, const char** line, size_t* size) {
+    if (file->position >= file->size)
+        return 0;
+
+    const char* start = file->data + file->position;
+    const char* end = memchr(start, '\n', file->size - file->position);
+    size_t line_size = end != NULL ? (size_t)(end - start) : file->size - file->position;
+
+    *line = start;
+    *size = line_size;
+    file->position += line_size + 1;
+    return 1;
+}
+
+/**
+ * @brief Whether tokens of this kind name are followed by a text line.
+ * 
+ */
+static int kind_has_text(const char* kind, size_t kind_size) {
+    for (int i = 0; i < TOKEN_KIND_COUNT; i++)
+        if (token_kind_name_sizes[i] == kind_size && memcmp(token_kind_names[i], kind, kind_size) == 0)
+            return TOKEN_HAS_TEXT(i);
+
+    return 0;
+}
+
+/**
+ * @brief Reads the next token of the file.
+ * 
+ * @return 1 if there was a token, 0 at the end of the file.
+ */
+static int next_token(LexFile* file, TokenText* token) {
+    *token = (TokenText){0};
+
+    if (!next_line(file, &token->line, &token->line_size))
+        return 0;
+
+    next_line(file, &token->kind, &token->kind_size);
+
+    if (kind_has_text(token->kind, token->kind_size))
+        next_line(file, &token->text, &token->text_size);
+
+    return 1;
+}
+
+static int same_field(const char* a, size_t a_size, const char* b, size_t b_size) {
+    return a_size == b_size && (a_size == 0 || memcmp(a, b, a_size) == 0);
+}
+
+static int same_token(const TokenText* a, const TokenText* b) {
+    return same_field(a->line, a->line_size, b->line, b->line_size) &&
+           same_field(a->kind, a->kind_size, b->kind, b->kind_size) &&
+           same_field(a->text, a->text_size, b->text, b->text_size);
+}
+
+static void print_token(const char* who, const TokenText* token) {
+    if (token->line == NULL) {
+        printf("    %-10s end of file\n", who);
+        return;
+    }
+
+    printf("    %-10s line %.*s, %.*s", who, (int)token->line_size, token->line, (int)token->kind_size, token->kind);
+
+    if (token->text != NULL)
+        printf(" %.*s", (int)token->text_size, token->text);
+
+    printf("\n");
+}
+
+/**
+ * @brief Compares two -lex files token by token and prints the first difference.
+ * 
+ * @param tokens Receives the number of tokens that matched.
+ * @return 1 if both files hold the same tokens, 0 otherwise.
+ */
+int compare_outputs(const char* reference_filename, const char* lexer_filename, size_t* tokens) {
+    LexFile reference = {0}, lexer = {0};
+    int same = 0;
+
+    *tokens = 0;
+    reference.data = read_whole_file(reference_filename, &reference.size);
+    lexer.data = read_whole_file(lexer_filename, &lexer.size);
+
+    if (reference.data == NULL || lexer.data == NULL) {
+        printf("\33[31mERROR:\33[0m could not read %s\n", reference.data == NULL ? reference_filename : lexer_filename);
+    } else {
+        while (1) {
+            TokenText reference_token, lexer_token;
+            int reference_more = next_token(&reference, &reference_token);
+            int lexer_more = next_token(&lexer, &lexer_token);
+
+            // Same tokens, the files can still differ after the last one
+            if (!reference_more && !lexer_more) {
+                same = reference.size == lexer.size && memcmp(reference.data, lexer.data, lexer.size) == 0;
+
+                if (!same)
+                    printf("\33[31mERROR:\33[0m %s has the same tokens as %s but not the same bytes\n", lexer_filename,
+                           reference_filename);
+                break;
+            }
+
+            if (reference_more != lexer_more || !same_token(&reference_token, &lexer_token)) {
+                printf("\33[31mERROR:\33[0m %s differs from %s at token %zu:\n", lexer_filename, reference_filename,
+                       *tokens + 1);
+                print_token("reference", &reference_token);
+                print_token("lexer", &lexer_token);
+                break;
+            }
+
+            (*tokens)++;
+        }
+    }
+
+    free(reference.data);
+    free(lexer.data);
+    return same;
+}
+
+/**
+ * @brief Tells if the file holds exactly the expected bytes, and prints what differs if not.
+ * 
+ * @param filename File written by the run being checked.
+ * @param run Description of the run, for the error message.
+ * @param expected Expected contents.
+ * @param expected_size Size of expected.
+ * @return 1 if the contents are the same, 0 otherwise.
+ */
+int same_contents(const char* filename, const char* run, const char* expected, size_t expected_size) {
+    size_t size;
+    char* data = read_whole_file(filename, &size);
+
+    if (data == NULL) {
+        printf("\33[31mERROR:\33[0m %s wrote no %s\n", run, filename);
+        return 0;
+    }
+
+    size_t position = 0;
+
+    while (position < size && position < expected_size && data[position] == expected[position])
+        position++;
+
+    free(data);
+
+    if (position == size && position == expected_size)
+        return 1;
+
+    printf("\33[31mERROR:\33[0m %s differs from the serial output at byte %zu of %s\n", run, position, filename);
+    return 0;
+}
+
+/**
+ * @brief Lexes the file in chunks with every split_options and checks the output is the serial one, byte for byte.
+ * 
+ * @param lexer This lexer.
+ * @param filename Source file.
+ * @param lexer_output Output file of the lexer, holds the last chunked output afterwards.
+ * @param serial Serial output.
+ * @param serial_size Size of serial.
+ * @return 1 if every run gave the serial output, 0 otherwise.
+ */
+int check_split(char* lexer, char* filename, const char* lexer_output, const char* serial, size_t serial_size) {
+    int same = 1;
+
+    for (size_t i = 0; same && i < sizeof(split_options) / sizeof(*split_options); i++) {
+        char* argv[] = {lexer, split_options[i][0], split_options[i][1], filename, NULL};
+        char run[256];
+        double seconds;
+
+        snprintf(run, sizeof(run), "%s %s %s", lexer, split_options[i][0], split_options[i][1]);
+        remove(lexer_output);
+
+        if (!run_timed(argv, &seconds)) {
+            printf("\33[31mERROR:\33[0m could not run %s\n", run);
+            same = 0;
+        } else {
+            same = same_contents(lexer_output, run, serial, serial_size);
+        }
+    }
+
+    return same;
+}
+
+/**
+ * @brief Lexes the file to the binary format, decodes it back with lexdecode and checks the result is the serial
+ * output, byte for byte. The binary and decoded files are removed afterwards.
+ * 
+ * @param lexer This lexer.
+ * @param decoder lexdecode.
+ * @param filename Source file.
+ * @param serial Serial output.
+ * @param serial_size Size of serial.
+ * @return 1 if the round trip gave the serial output, 0 otherwise.
+ */
+int check_binary(char* lexer, char* decoder, char* filename, const char* serial, size_t serial_size) {
+    size_t filename_size = strlen(filename);
+    char* binary_output = malloc(filename_size + 32);
+    char* decoded_output = malloc(filename_size + 32);
+
+    if (binary_output == NULL || decoded_output == NULL) {
+        printf("\33[31mERROR:\33[0m out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sprintf(binary_output, "%s-lexbin", filename);
+    sprintf(decoded_output, "%s.decoded-lex", filename);
+
+    char* lexer_argv[] = {lexer, "--format=binary", filename, NULL};
+    char* decoder_argv[] = {decoder, binary_output, decoded_output, NULL};
+    double seconds;
+    int same = 0;
+
+    remove(binary_output);
+    remove(decoded_output);
+
+    if (!run_timed(lexer_argv, &seconds))
+        printf("\33[31mERROR:\33[0m could not run %s --format=binary\n", lexer);
+    else if (!run_timed(decoder_argv, &seconds))
+        printf("\33[31mERROR:\33[0m could not run %s\n", decoder);
+    else
+        same = same_contents(decoded_output, "--format=binary decoded by lexdecode", serial, serial_size);
+
+    remove(binary_output);
+    remove(decoded_output);
+    free(binary_output);
+    free(decoded_output);
+    return same;
+}
+
+/**
+ * @brief Checks the other ways of lexing the file against its serial output: in chunks and through the binary format.
+ * 
+ * @return 1 if they all gave the serial output, 0 otherwise.
+ */
+int check_variants(char* lexer, char* decoder, char* filename, const char* lexer_output) {
+    size_t serial_size;
+    char* serial = read_whole_file(lexer_output, &serial_size);
+
+    if (serial == NULL) {
+        printf("\33[31mERROR:\33[0m could not read %s\n", lexer_output);
+        return 0;
+    }
+
+    int same = check_binary(lexer, decoder, filename, serial, serial_size) &&
+               check_split(lexer, filename, lexer_output, serial, serial_size);
+
+    free(serial);
+    return same;
+}
+
+/**
+ * @brief Lexes the file with both lexers, compares their outputs and prints their times.
+ * The reference lexer runs on filename.reference.cl, its output is filename.reference.cl-lex.
+ * Both are removed once compared, only the output of this lexer is kept.
+ * The output of this lexer must also stay the same when the file is lexed in chunks, and when it goes through
+ * the binary format and back.
+ * 
+ * @return 1 if the outputs are the same, 0 otherwise.
+ */
+int diff_file(char* reference_lexer, char* lexer, char* decoder, char* filename) {
+    size_t filename_size = strlen(filename);
+    char* copy = malloc(filename_size + 32);
+    char* reference_output = malloc(filename_size + 32);
+    char* lexer_output = malloc(filename_size + 32);
+    int same = 0;
+
+    if (copy == NULL || reference_output == NULL || lexer_output == NULL) {
+        printf("\33[31mERROR:\33[0m out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sprintf(copy, "%s.reference.cl", filename);
+    sprintf(reference_output, "%s-lex", copy);
+    sprintf(lexer_output, "%s-lex", filename);
+
+    char* reference_argv[] = {reference_lexer, "--lex", copy, NULL};
+    char* lexer_argv[] = {lexer, filename, NULL};
+    double reference_seconds = -1, lexer_seconds = -1;
+    size_t tokens;
+
+    // Stale outputs of an earlier run would hide a lexer that writes nothing
+    remove(reference_output);
+    remove(lexer_output);
+
+    if (!copy_file(filename, copy))
+        printf("\33[31mERROR:\33[0m could not copy %s to %s\n", filename, copy);
+    else if ((reference_seconds = run_median(reference_argv)) < 0)
+        printf("\33[31mERROR:\33[0m could not run %s\n", reference_lexer);
+    else if ((lexer_seconds = run_median(lexer_argv)) < 0)
+        printf("\33[31mERROR:\33[0m could not run %s\n", lexer);
+    else
+        same = compare_outputs(reference_output, lexer_output, &tokens) &&
+               check_variants(lexer, decoder, filename, lexer_output);
+
+    if (same) {
+        const char* name = strrchr(filename, '/') != NULL ? strrchr(filename, '/') + 1 : filename;
+        double megabytes = 0;
+        FILE* fp = fopen(filename, "rb");
+
+        if (fp != NULL && fseek(fp, 0, SEEK_END) == 0)
+            megabytes = ftell(fp) / 1e6;
+
+        if (fp != NULL)
+            fclose(fp);
+
+        printf("%-24s %10.2f %12zu %14.1f %12.1f %10.1fx   same\n", name, megabytes, tokens,
+               megabytes / reference_seconds, megabytes / lexer_seconds, reference_seconds / lexer_seconds);
+    }
+
+    remove(copy);
+    remove(reference_output);
+    free(copy);
+    free(reference_output);
+    free(lexer_output);
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [reference lexer] [lexer] [lexdecode] [files...]\n", argv[0]);
+        return LEXER_ERROR_INCORRECT_USAGE;
+    }
+
+    int failures = 0;
+
+    // Times are whole runs (start, lexing, writing the -lex file), median of DIFF_ROUNDS
+    printf("%-24s %10s %12s %14s %12s %11s   %s\n", "corpus", "MB", "tokens", "reference MB/s", "lexer MB/s",
+           "speedup", "output");
+
+    for (int i = 4; i < argc; i++)
+        failures += !diff_file(argv[1], argv[2], argv[3], argv[i]);
+
+    if (failures > 0) {
+        printf("\33[31mERROR:\33[0m %d of %d files failed the comparison\n", failures, argc - 4);
+        return EXIT_FAILURE;
+    }
+
+    return LEXER_OK;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "bench_util.h"
+#include "keyword.h"
+
+#define BENCH_ROUNDS    200000
+
+/**
+ * @brief Previous check_keyword implementation: lowercase copy followed by a linear strcmp scan.
+ * Kept here as the reference for correctness and speed.
+ */
+const char* check_keyword_linear(char* text) {
+    static const char* keywords[] = {"class", "else", "false", "fi", "if", 
+                                     "in", "inherits", "isvoid", "let", "loop", 
+                                     "pool", "then", "while", "case", "esac", 
+                                     "new", "of", "not", "true"};
+
+    size_t text_size = strlen(text) + 1;
+    char text_lower[text_size];
+
+    for (size_t i = 0; i < text_size; i++)
+        text_lower[i] = tolower(text[i]);
+    
+    for (int i = 0; i < ARRAYSIZE(keywords); i++) {
+        if (strcmp(text_lower, keywords[i]) == 0) {
+            return keywords[i];
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    static char* words[] = BENCH_WORDS;
+
+    // Both implementations must agree
+    for (int i = 0; i < ARRAYSIZE(words); i++) {
+        const char* expected = check_keyword_linear(words[i]);
+        TokenKind found = check_keyword(words[i], strlen(words[i]));
+
+        if ((expected == NULL) != (found == TOKEN_IDENTIFIER) || (expected != NULL && strcmp(expected, token_kind_names[found]) != 0)) {
+            printf("\33[31mERROR:\33[0m check_keyword mismatch for %s\n", words[i]);
+            return 1;
+        }
+    }
+
+    size_t word_sizes[ARRAYSIZE(words)];
+
+    for (int i = 0; i < ARRAYSIZE(words); i++)
+        word_sizes[i] = strlen(words[i]);
+
+    struct timespec start, end;
+    volatile size_t hits = 0;
+    double total_lookups = (double)BENCH_ROUNDS * ARRAYSIZE(words);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+        for (int i = 0; i < ARRAYSIZE(words); i++)
+            hits += check_keyword_linear(words[i]) != NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double linear_ns = elapsed_ns(start, end) / total_lookups;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+        for (int i = 0; i < ARRAYSIZE(words); i++)
+            hits += check_keyword(words[i], word_sizes[i]) != TOKEN_IDENTIFIER;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double hash_ns = elapsed_ns(start, end) / total_lookups;
+
+    printf("check_keyword linear scan:  %8.2f ns/lookup\n", linear_ns);
+    printf("check_keyword perfect hash: %8.2f ns/lookup (%.1fx)\n", hash_ns, linear_ns / hash_ns);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench_util.h"
+#include "lexer.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BENCH_HAS_TSC
+#include <x86intrin.h>
+#endif
+
+#define BENCH_ROUNDS    5
+
+/**
+ * @brief Measurement struct.
+ * One round over one file.
+ *
+ */
+typedef struct Measurement {
+    double seconds;
+    uint64_t cycles;
+    size_t tokens;
+} Measurement;
+
+static inline uint64_t read_cycles(void) {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Opens, lexes and closes filename once, touching every token text like a consumer would.
+ *
+ * @return 1 on success, 0 if the file couldn't be opened.
+ */
+int lex_once(const char* filename, Measurement* measurement) {
+    struct timespec start, end;
+    size_t tokens = 0, text_bytes = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t start_cycles = read_cycles();
+
+    Lexer* lexer = lexer_open_file(filename);
+
+    if (lexer == NULL)
+        return 0;
+
+    Token token;
+
+    while (lexer_next_token(lexer, &token)) {
+        size_t text_size;
+
+        lexer_token_text(lexer, &text_size);
+        text_bytes += text_size;
+        tokens++;
+    }
+
+    lexer_close(lexer);
+
+    uint64_t end_cycles = read_cycles();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Keeps the loop from being optimized away
+    __asm__ volatile("" : : "r"(text_bytes));
+
+    measurement->seconds = elapsed_seconds(start, end);
+    measurement->cycles = end_cycles - start_cycles;
+    measurement->tokens = tokens;
+    return 1;
+}
+
+int compare_measurements(const void* a, const void* b) {
+    double seconds_a = ((const Measurement*)a)->seconds;
+    double seconds_b = ((const Measurement*)b)->seconds;
+
+    return (seconds_a > seconds_b) - (seconds_a < seconds_b);
+}
+
+/**
+ * @brief Lexes filename BENCH_ROUNDS times after one warmup round and prints the median round.
+ *
+ * @return 1 on success, 0 if the file couldn't be read.
+ */
+int bench_file(const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+
+    if (fp == NULL || fseek(fp, 0, SEEK_END) != 0) {
+        if (fp != NULL)
+            fclose(fp);
+
+        return 0;
+    }
+
+    long size = ftell(fp);
+    fclose(fp);
+
+    Measurement rounds[BENCH_ROUNDS];
+
+    // Warmup: page cache, mapping and CPU frequency
+    if (size <= 0 || !lex_once(filename, &rounds[0]))
+        return 0;
+
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+        if (!lex_once(filename, &rounds[i]))
+            return 0;
+
+    qsort(rounds, BENCH_ROUNDS, sizeof(Measurement), compare_measurements);
+
+    const Measurement* median = &rounds[BENCH_ROUNDS / 2];
+    const char* name = strrchr(filename, '/') != NULL ? strrchr(filename, '/') + 1 : filename;
+
+    printf("%-24s %10.2f %12zu %10.1f %12.2f", name, size / 1e6, median->tokens,
+           size / 1e6 / median->seconds, median->tokens / 1e6 / median->seconds);
+
+#ifdef BENCH_HAS_TSC
+    printf(" %12.2f\n", (double)median->cycles / size);
+#else
+    printf(" %12s\n", "n/a");
+#endif
+
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [files...]\n", argv[0]);
+        return LEXER_ERROR_INCORRECT_USAGE;
+    }
+
+    // Cycles are TSC ticks: constant rate, not core cycles when the CPU clock changes
+    printf("%-24s %10s %12s %10s %12s %12s\n", "corpus", "MB", "tokens", "MB/s", "Mtokens/s", "cycles/byte");
+
+    for (int i = 1; i < argc; i++) {
+        if (!bench_file(argv[i])) {
+            printf("\33[31mERROR:\33[0m could not lex file %s\n", argv[i]);
+            return LEXER_ERROR_FILE_IO;
+        }
+    }
+
+    return LEXER_OK;
+}
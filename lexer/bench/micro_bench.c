@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "arena.h"
+#include "bench_util.h"
+#include "keyword.h"
+#include "lexer.h"
+#include "lexer_internal.h"
+#include "read_buffer.h"
+#include "token.h"
+
+// Samples per benchmark, the first ones are only warmup and aren't reported
+#define MICRO_WARMUP_SAMPLES    20
+#define MICRO_SAMPLES           200
+
+/**
+ * @brief Inputs struct.
+ * Everything the benchmarks run on, built once before timing.
+ * Each read buffer holds one input, terminal_starts lists where each terminal begins.
+ * 
+ */
+typedef struct Inputs {
+    ReadBuffer source;
+
+    ReadBuffer terminals;
+    size_t terminal_starts[32];
+    int terminal_count;
+
+    ReadBuffer strings[3];
+
+    Arena arena;
+} Inputs;
+
+/**
+ * @brief Benchmark struct.
+ * One function on one input. run does ops calls of the function and returns something that depends on them,
+ * so the calls can't be optimized away.
+ * 
+ */
+typedef struct Benchmark {
+    const char* function;
+    const char* input;
+    size_t ops;
+    size_t (*run)(Inputs* inputs, const struct Benchmark* benchmark);
+    int index;
+} Benchmark;
+
+static const char cool_source[] =
+    "class Main inherits IO {\n"
+    "    main() : Object {\n"
+    "        let x : Int <- 42, s : String <- \"hello world\" in {\n"
+    "            -- print the value\n"
+    "            if x <= 100 then out_int(x * 2 + 1) else out_string(s) fi;\n"
+    "            (* not reached (* nested *) *)\n"
+    "            while not isvoid self loop x <- x - 1 pool;\n"
+    "        }\n"
+    "    };\n"
+    "};\n";
+
+static const char* const terminals[] = {"(", ")", "*", "+", ",", "-", ".", "/", ":", ";", "<-", "<=", "<", "=>",
+                                        "=", "@", "{", "}", "~"};
+
+static const char* const words[] = BENCH_WORDS;
+
+static const char* const integers[] = {"0", "7", "42", "100", "2024", "65535", "123456", "1000000",
+                                       "12345678", "987654321", "2147483647", "2147483648", "00000000042"};
+
+static const char* const string_literals[3] = {
+    "\"hello world\"",
+    "\"The lexer reads a COOL source and writes its tokens out, one per line, with the kind, the line number and "
+    "the text of identifiers, types, integers and strings. This literal is long enough to show the cost per byte "
+    "of the string scanner rather than the cost per call, which matters for sources that embed large tables.\"",
+    "\"tab\\there, quote \\\" and newline \\n escapes, then an escaped line break \\\n and the rest\"",
+};
+
+/**
+ * @brief Opens text as an in-memory read buffer, so every function sees the same sentinel padding as in the lexer.
+ * 
+ */
+static void open_input(ReadBuffer* read_buffer, const char* text, size_t size) {
+    if (!init_buffer_memory(read_buffer, text, size, "bench")) {
+        printf("\33[31mERROR:\33[0m out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void build_inputs(Inputs* inputs) {
+    *inputs = (Inputs){0};
+
+    open_input(&inputs->source, cool_source, sizeof(cool_source) - 1);
+
+    // Terminals separated by spaces, so a one char terminal isn't read as the start of a two char one
+    char text[256];
+    size_t size = 0;
+
+    for (int i = 0; i < ARRAYSIZE(terminals); i++) {
+        inputs->terminal_starts[inputs->terminal_count++] = size;
+        size += sprintf(text + size, "%s ", terminals[i]);
+    }
+
+    open_input(&inputs->terminals, text, size);
+
+    for (int i = 0; i < 3; i++)
+        open_input(&inputs->strings[i], string_literals[i], strlen(string_literals[i]));
+}
+
+static void free_inputs(Inputs* inputs) {
+    free_buffer(&inputs->source);
+    free_buffer(&inputs->terminals);
+
+    for (int i = 0; i < 3; i++)
+        free_buffer(&inputs->strings[i]);
+
+    arena_free(&inputs->arena);
+}
+
+static size_t run_next_char(Inputs* inputs, const Benchmark* benchmark) {
+    ReadBuffer* read_buffer = &inputs->source;
+    size_t sum = 0;
+
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        if (read_buffer->current_position == read_buffer->total_size)
+            read_buffer->current_position = 0;
+
+        sum += (uint8_t)next_char(read_buffer);
+    }
+
+    return sum;
+}
+
+static size_t run_next_char_lookup(Inputs* inputs, const Benchmark* benchmark) {
+    ReadBuffer* read_buffer = &inputs->source;
+    size_t sum = 0;
+    size_t position = 0;
+
+    // Looks at every char in turn without reading it
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        read_buffer->current_position = position;
+        sum += (uint8_t)next_char_lookup(read_buffer);
+
+        if (++position == read_buffer->total_size)
+            position = 0;
+    }
+
+    return sum;
+}
+
+static size_t run_check_keyword(Inputs* inputs, const Benchmark* benchmark) {
+    static size_t sizes[ARRAYSIZE(words)];
+    size_t sum = 0;
+    (void)inputs;
+
+    if (sizes[0] == 0)
+        for (int i = 0; i < ARRAYSIZE(words); i++)
+            sizes[i] = strlen(words[i]);
+
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        size_t word = i % ARRAYSIZE(words);
+        sum += check_keyword(words[word], sizes[word]);
+    }
+
+    return sum;
+}
+
+static size_t run_parse_integer(Inputs* inputs, const Benchmark* benchmark) {
+    static size_t sizes[ARRAYSIZE(integers)];
+    size_t sum = 0;
+    (void)inputs;
+
+    if (sizes[0] == 0)
+        for (int i = 0; i < ARRAYSIZE(integers); i++)
+            sizes[i] = strlen(integers[i]);
+
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        size_t integer = i % ARRAYSIZE(integers);
+        int32_t value = 0;
+
+        sum += parse_integer(integers[integer], sizes[integer], &value) + value;
+    }
+
+    return sum;
+}
+
+static size_t run_extract_terminal(Inputs* inputs, const Benchmark* benchmark) {
+    ReadBuffer* read_buffer = &inputs->terminals;
+    size_t sum = 0;
+
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        // Positioned just after the first char, as the lexer calls it
+        read_buffer->current_position = inputs->terminal_starts[i % inputs->terminal_count] + 1;
+        sum += extract_terminal(read_buffer);
+    }
+
+    return sum;
+}
+
+static size_t run_extract_string(Inputs* inputs, const Benchmark* benchmark) {
+    ReadBuffer* read_buffer = &inputs->strings[benchmark->index];
+    size_t sum = 0;
+
+    for (size_t i = 0; i < benchmark->ops; i++) {
+        const char* text;
+        size_t text_size;
+
+        // Positioned just after the opening quote
+        read_buffer->current_position = 1;
+        sum += extract_string(read_buffer, &inputs->arena, &text, &text_size, NULL) + text_size;
+    }
+
+    return sum;
+}
+
+static const Benchmark benchmarks[] = {
+    {"next_char",           "cool source",          4096, run_next_char,           0},
+    {"next_char_lookup",    "cool source",          4096, run_next_char_lookup,    0},
+    {"check_keyword",       "mixed words",          4096, run_check_keyword,       0},
+    {"parse_integer",       "1 to 11 digits",       4096, run_parse_integer,       0},
+    {"extract_terminal",    "all terminals",        4096, run_extract_terminal,    0},
+    {"extract_string",      "short",                1024, run_extract_string,      0},
+    {"extract_string",      "long",                 256,  run_extract_string,      1},
+    {"extract_string",      "escapes",              1024, run_extract_string,      2},
+};
+
+/**
+ * @brief Times the benchmark MICRO_SAMPLES times (after MICRO_WARMUP_SAMPLES untimed ones) and writes one CSV row.
+ * Each sample is ops calls, its time per call is a sample value. The arena is emptied between samples, untimed.
+ * 
+ */
+static void run_benchmark(Inputs* inputs, const Benchmark* benchmark, FILE* csv) {
+    static double samples[MICRO_SAMPLES];
+    volatile size_t sink = 0;
+
+    for (int i = 0; i < MICRO_WARMUP_SAMPLES + MICRO_SAMPLES; i++) {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sink += benchmark->run(inputs, benchmark);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        arena_free(&inputs->arena);
+
+        if (i >= MICRO_WARMUP_SAMPLES)
+            samples[i - MICRO_WARMUP_SAMPLES] = elapsed_ns(start, end) / benchmark->ops;
+    }
+
+    qsort(samples, MICRO_SAMPLES, sizeof(double), compare_doubles);
+
+    double median = samples[MICRO_SAMPLES / 2];
+    double p99 = samples[(MICRO_SAMPLES * 99 + 99) / 100 - 1];
+
+    fprintf(csv, "%s,%s,%zu,%d,%.3f,%.3f,%.3f\n", benchmark->function, benchmark->input, benchmark->ops,
+            MICRO_SAMPLES, median, p99, samples[0]);
+}
+
+int main(int argc, char* argv[]) {
+    FILE* csv = stdout;
+
+    if (argc > 2) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [csv output file]\n", argv[0]);
+        return LEXER_ERROR_INCORRECT_USAGE;
+    }
+
+    if (argc == 2 && (csv = fopen(argv[1], "w")) == NULL) {
+        printf("\33[31mERROR:\33[0m could not open output file %s\n", argv[1]);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    Inputs inputs;
+    build_inputs(&inputs);
+
+    fprintf(csv, "function,input,ops_per_sample,samples,median_ns_per_op,p99_ns_per_op,min_ns_per_op\n");
+
+    for (int i = 0; i < ARRAYSIZE(benchmarks); i++)
+        run_benchmark(&inputs, &benchmarks[i], csv);
+
+    free_inputs(&inputs);
+
+    if (csv != stdout && fclose(csv) != 0) {
+        printf("\33[31mERROR:\33[0m could not write output file %s\n", argv[1]);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    return LEXER_OK;
+}
@@ -0,0 +1,7 @@
+class Main {
+    main() : Int { 0 };
+};
+(* an unterminated comment at the end
+   (* nested once
+      (* and twice
+         until the end of the file
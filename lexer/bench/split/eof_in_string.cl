@@ -0,0 +1,4 @@
+class Main inherits IO {
+    main() : Object { out_string("an unterminated string \
+over escaped newlines \
+until the end of the file\
@@ -0,0 +1,26 @@
+class Main inherits IO {
+    main() : Object {
+        {
+            out_string("one line, \
+two lines, \
+three lines, and a tab\tafter them\n");
+            out_string("\
+\
+\
+starts with escaped newlines");
+            out_string("looks like code: \
+x <- 1; (* not a comment *) -- nor this\
+\"quoted\" and a backslash \\ mid line\
+");
+            out_string("an escaped quote at the end of a line \"\
+and one at the start\
+\" of the next");
+            out_string("a backslash before the escaped newline \\\
+still the same string");
+            out_string("long continued line ........................................................\
+........................................................................................\
+.................................................................. end");
+            out_int(42);
+        }
+    };
+};
@@ -0,0 +1,33 @@
+class Main inherits IO {
+    (* depth 1
+       (* depth 2
+          (* depth 3
+             (* depth 4
+                (* depth 5
+                   (* depth 6, a line long enough to hold a whole chunk by itself ........
+                   *)
+                *)
+             back at depth 4
+             *)
+          *)
+       *)
+    *)
+    main() : Object {
+        {
+            (* (* (* three opened on one line
+            still at depth 3 ... "a string that isn't one
+            -- neither is this a line comment *)
+            depth 2 *)
+            depth 1 *)
+            out_string("after the comments");
+            (*(*(*(*
+            deep without spaces
+            *)*)*)*)
+            -- a line comment that opens (* but doesn't nest
+            out_int(1);
+            (* a closing star alone at the end of a line *
+            ) still inside, (* one more level
+            **) ***) out_int(2);
+        }
+    };
+};
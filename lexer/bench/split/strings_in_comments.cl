@@ -0,0 +1,21 @@
+class Main inherits IO {
+    x : String <- "(* not a comment";
+    y : String <- "-- not a line comment either";
+    z : String <- "*) stray closer inside a string";
+    (* a comment with a quote " that never closes
+       and a backslash at the end of a line \
+       "and a whole string" *)
+    -- a line comment with a quote " and a backslash \
+    main() : Object {
+        {
+            out_string(x.concat(y).concat(z));
+            out_string("a string with (* and *) in it, \
+continued with -- inside it, \
+and (* again (* twice");
+            out_string("an unescaped newline ends this one
+            out_int(3);
+            out_string("a backslash then a real newline \\
+            out_int(4);
+        }
+    };
+};
@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Constants
+#define ARENA_PAGE_SIZE             (1024 * 1024)
+
+/**
+ * @brief ArenaPage struct.
+ * One block of arena memory, pages are chained from the newest to the oldest.
+ * 
+ */
+typedef struct ArenaPage {
+    struct ArenaPage* next;
+    char data[];
+} ArenaPage;
+
+/**
+ * @brief Arena struct.
+ * Bump pointer allocator for token texts. Memory is taken from large pages and only given back all at once
+ * by arena_free, so allocating is a pointer bump and nothing is freed one by one.
+ * Texts of unknown size are built in place at the current position with arena_reserve, then kept with arena_commit.
+ * A zeroed arena is empty and ready to use. When out of memory, arena_reserve and arena_alloc return NULL
+ * and the arena is left as it was.
+ * 
+ */
+typedef struct Arena {
+    ArenaPage* pages;
+    char* position;
+    char* end;
+} Arena;
+
+char* arena_reserve(Arena* arena, size_t used, size_t size, size_t* capacity);
+char* arena_alloc(Arena* arena, size_t size);
+void arena_free(Arena* arena);
+
+/**
+ * @brief Keeps the size bytes built at the current position (see arena_reserve), the next text starts after them.
+ * 
+ * @param arena Arena.
+ * @param size Bytes to keep, at most the capacity given by the last arena_reserve.
+ */
+static inline void arena_commit(Arena* arena, size_t size) {
+    arena->position += size;
+}
+
+#endif
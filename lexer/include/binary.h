@@ -0,0 +1,28 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "binary_reader.h"
+#include "output.h"
+#include "token.h"
+
+// Longest varint, the one of a 64-bit value
+#define BINARY_MAX_VARINT_SIZE      10
+
+/**
+ * @brief BinaryWriter struct.
+ * Encodes tokens into out. line and symbol_count are the line of the last token and the number of symbols written.
+ * 
+ */
+typedef struct BinaryWriter {
+    OutputBuffer* out;
+    uint32_t line;
+    uint32_t symbol_count;
+} BinaryWriter;
+
+void binary_writer_init(BinaryWriter* writer, OutputBuffer* out);
+void write_token_binary(BinaryWriter* writer, const Token* token, const char* text, size_t text_size);
+
+#endif
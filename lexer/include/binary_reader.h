@@ -0,0 +1,83 @@
+#ifndef BINARY_READER_H
+#define BINARY_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "token.h"
+
+/*
+ * Binary token format (.cl-lexbin)
+ *
+ * Header: the magic "CLLX" followed by one version byte.
+ * Then one record per token:
+ *   - kind: one byte (TokenKind)
+ *   - line: varint, difference from the line of the previous token (the first token counts from 0)
+ *   - symbol: only for identifiers and types, varint symbol id. Ids are numbered from 0 in order of first
+ *     appearance, so an id equal to the number of symbols seen so far is a new one and is followed by its text
+ *   - text: only for integers, strings, errors and new symbols, varint size followed by the bytes
+ * The stream ends with a TOKEN_EOF record, so truncated files are detected.
+ * Each name is stored once, the symbol table is rebuilt by the reader as the tokens are read.
+ *
+ * Varints are unsigned LEB128: 7 bits per byte, lowest first, high bit set on all bytes but the last.
+ */
+#define BINARY_MAGIC                "CLLX"
+#define BINARY_MAGIC_SIZE           4
+#define BINARY_VERSION              3
+#define BINARY_HEADER_SIZE          (BINARY_MAGIC_SIZE + 1)
+
+/**
+ * @brief BinarySymbol struct.
+ * Name of a symbol read so far, it points into the stream.
+ * 
+ */
+typedef struct BinarySymbol {
+    const char* text;
+    size_t size;
+} BinarySymbol;
+
+/**
+ * @brief BinaryReader struct.
+ * Decodes a binary token stream that is fully in memory. Token texts point into the stream itself.
+ * 
+ */
+typedef struct BinaryReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    uint32_t line;
+
+    BinarySymbol* symbols;
+    uint32_t symbol_count;
+    uint32_t symbol_capacity;
+} BinaryReader;
+
+/**
+ * @brief Checks the header of a binary token stream and prepares to read its tokens.
+ * 
+ * @param reader Binary reader to initialize.
+ * @param data Whole stream.
+ * @param size Size of data.
+ * @return 1 on success, 0 if the magic or the version don't match.
+ */
+LEXER_API int binary_reader_init(BinaryReader* reader, const uint8_t* data, size_t size);
+
+/**
+ * @brief Reads the next token record. Kind, line, symbol and value are stored, offset and length are set to 0.
+ * 
+ * @param reader Binary reader.
+ * @param token Receives the token.
+ * @param text Receives the text of the token (not null terminated), or NULL for keywords and terminals.
+ * @param text_size Receives the size of text.
+ * @return 1 if a token was read, 0 at the TOKEN_EOF record, -1 if the stream is malformed or truncated.
+ */
+LEXER_API int binary_read_token(BinaryReader* reader, Token* token, const char** text, size_t* text_size);
+
+/**
+ * @brief Frees the symbols read so far. The stream itself belongs to the caller.
+ * 
+ * @param reader Binary reader.
+ */
+LEXER_API void binary_reader_free(BinaryReader* reader);
+
+#endif
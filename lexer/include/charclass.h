@@ -0,0 +1,20 @@
+#ifndef CHARCLASS_H
+#define CHARCLASS_H
+
+#include <stdint.h>
+
+// Character classes, a char may belong to several of them
+#define CHAR_CLASS_NAME_START       0x01    // Letters and '_'
+#define CHAR_CLASS_NAME             0x02    // Letters, digits and '_'
+#define CHAR_CLASS_WHITESPACE       0x04    // ' ', '\t', '\n', '\v', '\f' and '\r'
+#define CHAR_CLASS_DIGIT            0x08    // '0' to '9'
+#define CHAR_CLASS_TERMINAL_START   0x10    // First char of an operator or punctuation
+#define CHAR_CLASS_STRING_START     0x20    // '"'
+
+// Classes of every byte. Plain ASCII only, so it doesn't depend on the locale like ctype
+extern const uint8_t char_classes[256];
+
+// Checks if char _C belongs to class _CLASS, _C may be a (signed) char or EOF
+#define CHAR_IS(_C, _CLASS)         (char_classes[(uint8_t)(_C)] & (_CLASS))
+
+#endif
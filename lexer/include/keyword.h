@@ -0,0 +1,18 @@
+#ifndef KEYWORD_H
+#define KEYWORD_H
+
+#include <stddef.h>
+
+#include "token.h"
+
+/**
+ * @brief Checks if text is a COOL keyword (case insensitive).
+ * Uses a perfect hash keyed on the length and the first and last chars, so at most one keyword is compared.
+ * 
+ * @param text Identifier text, doesn't need to be null terminated.
+ * @param length Size of text.
+ * @return Kind of the keyword, or TOKEN_IDENTIFIER if text isn't a keyword.
+ */
+TokenKind check_keyword(const char* text, size_t length);
+
+#endif
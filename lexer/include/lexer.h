@@ -0,0 +1,189 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+
+#include "token.h"
+
+// Return codes codes
+#define LEXER_OK                                0
+#define LEXER_ERROR_INCORRECT_USAGE             1
+#define LEXER_ERROR_FILE_IO                     2
+#define LEXER_ERROR_IDENTIFIER_NAME_TOO_LONG    3   // Not produced anymore, names have no length limit
+#define LEXER_ERROR_STRING_LITERAL_TOO_LONG     4
+#define LEXER_ERROR_WRONG_INTEGER32_FORMAT      5
+#define LEXER_ERROR_UPPERCASE_BOOLEAN_KEYWORD   6
+#define LEXER_ERROR_INVALID_CHARACTER           7
+#define LEXER_ERROR_INVALID_STRING_CHARACTER    8
+#define LEXER_ERROR_NON_ESCAPED_NEWLINE         9
+#define LEXER_ERROR_MALFORMED_BINARY            10
+#define LEXER_ERROR_OUT_OF_MEMORY               11
+
+// Default chunk size of lexer_lex_parallel
+#define LEXER_DEFAULT_CHUNK_SIZE                (1024 * 1024)
+
+/**
+ * @brief Lexing session over one source. Tokens are pulled one at a time with lexer_next_token.
+ * Lexical errors don't stop the lexer: the offending input becomes a TOKEN_ERROR token and the error is
+ * added to the diagnostics, which can be printed at the end with lexer_report_diagnostics.
+ * 
+ */
+typedef struct Lexer Lexer;
+
+/**
+ * @brief LexerDiagnostic struct.
+ * One lexical error. message may contain null chars (an invalid '\0' in the source), hence its size.
+ * 
+ */
+typedef struct LexerDiagnostic {
+    int code;
+    size_t line;
+    char* message;
+    size_t message_size;
+    const char* hint;
+} LexerDiagnostic;
+
+/**
+ * @brief LexerStats struct.
+ * Where the time of one source went, see lexer_stats. Times are ticks of the CPU cycle counter (TSC).
+ * skip_ticks is spent skipping whitespace and comments, token_ticks reading tokens and symbol_ticks interning names.
+ * Every token is counted, but only one in 64 is timed: the times are estimates scaled up from those.
+ * When the source is lexed in chunks, the times of every thread are added up.
+ * 
+ */
+typedef struct LexerStats {
+    size_t bytes;
+    size_t refills;
+    size_t tokens[TOKEN_KIND_COUNT];
+    uint64_t skip_ticks;
+    uint64_t token_ticks;
+    uint64_t symbol_ticks;
+} LexerStats;
+
+/**
+ * @brief Opens filename for lexing. Regular files are memory mapped, anything else is read in blocks.
+ * 
+ * @param filename File to read, also used in error messages.
+ * @return New lexer, or NULL if the file couldn't be opened.
+ */
+LEXER_API Lexer* lexer_open_file(const char* filename);
+
+/**
+ * @brief Opens a source that is already in memory. data is copied, so it may be freed right after this call.
+ * 
+ * @param data Source text, doesn't need to be null terminated.
+ * @param size Size of data.
+ * @param name Name of the source, used in error messages.
+ * @return New lexer, or NULL if out of memory.
+ */
+LEXER_API Lexer* lexer_open_memory(const char* data, size_t size, const char* name);
+
+/**
+ * @brief Reads the next token.
+ * 
+ * @param lexer Lexer.
+ * @param token Receives the token, its kind is TOKEN_EOF at the end of the source.
+ * @return 1 if a token was read, 0 at the end of the source. Running out of memory also ends the source:
+ * it's reported as a LEXER_ERROR_OUT_OF_MEMORY diagnostic and every later call returns 0.
+ */
+LEXER_API int lexer_next_token(Lexer* lexer, Token* token);
+
+/**
+ * @brief Text of the last token read: name of identifiers and types, digits of integers, contents of strings
+ * and the offending input of errors. Empty for the other tokens. Texts stay valid until lexer_close.
+ * When the source is fully in memory most texts point straight into it, so they are not null terminated.
+ * 
+ * @param lexer Lexer.
+ * @param size If not NULL, receives the size of the text.
+ * @return Text, not null terminated.
+ */
+LEXER_API const char* lexer_token_text(const Lexer* lexer, size_t* size);
+
+/**
+ * @brief Number of distinct identifier and type names seen so far. Token symbols go from 0 to this count - 1,
+ * numbered in order of first appearance.
+ * 
+ * @param lexer Lexer.
+ * @return Number of symbols.
+ */
+LEXER_API uint32_t lexer_symbol_count(const Lexer* lexer);
+
+/**
+ * @brief Name of a symbol, the same text as lexer_token_text gives for its tokens.
+ * 
+ * @param lexer Lexer.
+ * @param symbol Symbol of an identifier or type token, less than lexer_symbol_count.
+ * @param size If not NULL, receives the size of the name.
+ * @return Name, not null terminated. Valid until lexer_close.
+ */
+LEXER_API const char* lexer_symbol_text(const Lexer* lexer, uint32_t symbol, size_t* size);
+
+/**
+ * @brief Diagnostics found so far, in source order.
+ * 
+ * @param lexer Lexer.
+ * @param count Receives the number of diagnostics.
+ * @return The diagnostics, valid until the next token is read or the lexer is closed.
+ */
+LEXER_API const LexerDiagnostic* lexer_diagnostics(const Lexer* lexer, size_t* count);
+
+/**
+ * @brief Prints every diagnostic on stdout as "name:line: ERROR: message", followed by its hint if it has one.
+ * 
+ * @param lexer Lexer.
+ * @return LEXER_OK if there were no errors, otherwise the LEXER_ERROR code of the first one.
+ */
+LEXER_API int lexer_report_diagnostics(const Lexer* lexer);
+
+/**
+ * @brief Statistics of the source so far: bytes read, blocks read (0 for mapped files and memory inputs),
+ * tokens of each kind and time spent in each phase. Only collected when built with LEXER_STATS (make STATS=YES).
+ * 
+ * @param lexer Lexer.
+ * @param stats Receives the statistics, zeroed if they aren't collected.
+ * @return 1 if the statistics are collected, 0 otherwise.
+ */
+LEXER_API int lexer_stats(const Lexer* lexer, LexerStats* stats);
+
+/**
+ * @brief Receives the tokens of lexer_lex_parallel, in source order.
+ * 
+ * @param context Context given to lexer_lex_parallel.
+ * @param token Token, the last one has kind TOKEN_EOF. Its symbol is already known to lexer_symbol_text.
+ * @param text Text of the token, as with lexer_token_text (not null terminated).
+ * @param text_size Size of text.
+ */
+typedef void (*LexerTokenCallback)(void* context, const Token* token, const char* text, size_t text_size);
+
+/**
+ * @brief Lexes the whole source on several threads and hands every token, then the TOKEN_EOF one, to callback.
+ * The source is split into chunks at line starts. Since a chunk may begin inside a multi-line string or comment,
+ * each chunk is lexed speculatively once for every state it could begin in, and the runs whose entry state
+ * matches the exit state of the previous chunk are stitched together. Comments are assumed one level deep, a chunk
+ * that begins deeper is lexed again while stitching. Line numbers are fixed up with the newline count of the chunks
+ * before. Each chunk interns its names in its own symbol table, and the tables are merged in source order.
+ * Tokens, symbols and diagnostics come out exactly as with lexer_next_token.
+ * Chunks are lexed a window at a time (about 1 MiB of source per thread) and handed out before the next window
+ * is lexed, so memory use depends on the window and not on the size of the source.
+ * With a single job, and for sources that aren't fully in memory (pipes), the source is lexed serially.
+ * When memory runs out, the rest of the source is lexed serially from the chunk where it happened. If that chunk
+ * begins inside a string or comment, the source ends there, reported as a LEXER_ERROR_OUT_OF_MEMORY diagnostic.
+ * Must be called before lexer_next_token.
+ * 
+ * @param lexer Lexer.
+ * @param jobs Number of threads.
+ * @param chunk_size Approximate size of the chunks in bytes.
+ * @param callback Receives the tokens, always called on the calling thread.
+ * @param context Passed to callback.
+ * @return 1 if at least part of the source was lexed in chunks, 0 if it was all lexed serially.
+ */
+LEXER_API int lexer_lex_parallel(Lexer* lexer, int jobs, size_t chunk_size, LexerTokenCallback callback, void* context);
+
+/**
+ * @brief Closes the source and frees the lexer. Accepts NULL.
+ * 
+ * @param lexer Lexer.
+ */
+LEXER_API void lexer_close(Lexer* lexer);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef LEXER_INTERNAL_H
+#define LEXER_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "lexer.h"
+#include "read_buffer.h"
+#include "symbol.h"
+#include "token.h"
+
+// Pieces of lexer.c shared with the other lexer modules, not part of the public API
+
+// Constants
+#define LITERAL_STRING_MAX_SIZE     1024
+
+/**
+ * @brief DiagnosticList struct.
+ * Growable list of diagnostics. status is the code of the first error, even if it couldn't be stored.
+ * failed is set when lexing can't go on (out of memory), see report_out_of_memory.
+ * 
+ */
+typedef struct DiagnosticList {
+    LexerDiagnostic* items;
+    size_t count;
+    size_t capacity;
+    int status;
+    int failed;
+} DiagnosticList;
+
+/**
+ * @brief Lexer struct.
+ * One lexing session over a single source, see lexer.h.
+ * Token texts point into the input or, when they can't, into the arena. Both live until the lexer is closed.
+ * text points to the text of the last token. symbols holds the names of identifiers and types, copied into the arena.
+ * stats is only kept up to date when built with LEXER_STATS, stats_sample picks the tokens it times (see STATS_SAMPLE).
+ * 
+ */
+struct Lexer {
+    ReadBuffer read_buffer;
+    FILE* fp;
+    char* name;
+    Arena arena;
+    const char* text;
+    size_t text_size;
+    DiagnosticList diagnostics;
+    SymbolTable symbols;
+    LexerStats stats;
+    uint32_t stats_sample;
+};
+
+void report_out_of_memory(DiagnosticList* diagnostics, ReadBuffer* read_buffer);
+void move_diagnostics(DiagnosticList* dest, DiagnosticList* src, size_t line_shift);
+void free_diagnostics(DiagnosticList* diagnostics);
+
+int iswhitespace(char c);
+int extract_string(ReadBuffer* read_buffer, Arena* arena, const char** text, size_t* text_size, DiagnosticList* diagnostics);
+TokenKind extract_terminal(ReadBuffer* read_buffer);
+int parse_integer(const char* text, size_t text_size, int32_t* value);
+size_t skip_block_comment(ReadBuffer* read_buffer, size_t depth, size_t end);
+int remove_comments(ReadBuffer* read_buffer);
+char skip_to_token(ReadBuffer* read_buffer);
+size_t lex_token(ReadBuffer* read_buffer, char current_char, Arena* arena, const char** text, Token* token, DiagnosticList* diagnostics);
+size_t next_token(ReadBuffer* read_buffer, Arena* arena, const char** text, Token* token, DiagnosticList* diagnostics,
+                  LexerStats* stats);
+
+#endif
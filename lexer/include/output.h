@@ -0,0 +1,64 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "token.h"
+
+// Constants
+#define OUTPUT_BUFFER_SIZE          (256 * 1024)
+#define OUTPUT_MAX_NUMBER_SIZE      10
+
+/**
+ * @brief OutputBuffer struct.
+ * Collects the output in a large user space buffer and writes it to the file with write(2) only when full.
+ * Write errors are remembered and reported by output_close.
+ * 
+ */
+typedef struct OutputBuffer {
+    int fd;
+    int failed;
+    size_t used;
+    char data[OUTPUT_BUFFER_SIZE];
+} OutputBuffer;
+
+OutputBuffer* output_open(const char* filename);
+void output_flush(OutputBuffer* out);
+void output_write_slow(OutputBuffer* out, const void* data, size_t size);
+int output_close(OutputBuffer* out);
+void write_token_text(OutputBuffer* out, const Token* token, const char* text, size_t text_size);
+
+/**
+ * @brief Makes sure there are at least size free bytes at the end of the buffer.
+ * 
+ * @param out Output buffer.
+ * @param size Bytes needed, at most OUTPUT_BUFFER_SIZE.
+ * @return Where the next bytes may be written.
+ */
+static inline char* output_reserve(OutputBuffer* out, size_t size) {
+    if (OUTPUT_BUFFER_SIZE - out->used < size)
+        output_flush(out);
+
+    return out->data + out->used;
+}
+
+/**
+ * @brief Appends size bytes to the buffer.
+ * 
+ * @param out Output buffer.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ */
+static inline void output_write(OutputBuffer* out, const void* data, size_t size) {
+    if (OUTPUT_BUFFER_SIZE - out->used < size) {
+        output_write_slow(out, data, size);
+        return;
+    }
+
+    memcpy(out->data + out->used, data, size);
+    out->used += size;
+}
+
+#endif
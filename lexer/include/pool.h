@@ -0,0 +1,30 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Task run by the pool.
+ * 
+ * @param context Shared context given to pool_run.
+ * @param task Index of the task.
+ * @param worker Index of the worker running it, from 0 to worker_count - 1.
+ */
+typedef void (*PoolTask)(void* context, size_t task, int worker);
+
+/**
+ * @brief Runs task_count tasks on worker_count threads with work stealing, and waits for all of them.
+ * Tasks are dealt round robin to the workers in the given order. Each worker runs its own tasks front to back,
+ * and when it runs out it steals from the back of another worker's queue. So when the order is largest first,
+ * big tasks start early and the small ones fill the gaps at the end.
+ * 
+ * @param worker_count Number of threads, 1 runs everything in the calling thread.
+ * @param task_count Number of tasks.
+ * @param order Task indices in the order they should start, NULL for 0 to task_count - 1.
+ * @param task Function run for every task.
+ * @param context Passed to every call of task.
+ * @return 1 on success, 0 if the threads couldn't be created (nothing was run).
+ */
+int pool_run(int worker_count, size_t task_count, const size_t* order, PoolTask task, void* context);
+
+#endif
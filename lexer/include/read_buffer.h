@@ -0,0 +1,113 @@
+#ifndef READ_BUFFER_H
+#define READ_BUFFER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "scan.h"
+
+// Constants
+#define INPUT_FILE_BLOCK_SIZE       4096
+#define READ_BUFFER_KEEP_SIZE       1
+#define READ_BUFFER_PADDING         64
+#define READ_BUFFER_SENTINEL        ((uint8_t)EOF)
+
+_Static_assert(READ_BUFFER_PADDING >= SCAN_MAX_OVERREAD, "sentinel padding must cover the SIMD scanners overread");
+
+/**
+ * @brief ReadBuffer struct.
+ * Automatically manages rebuffering, line counting and lookaheads.
+ * Regular files are memory mapped as a whole, so data points to the mapping and no refills happen.
+ * Anything that can't be mapped (pipes, empty files) falls back to reading 4096 byte blocks into content.
+ * Inputs already in memory are copied once into an allocated buffer with room for the padding.
+ * In every case the data is followed by READ_BUFFER_PADDING sentinel bytes, so reading never needs a bounds check:
+ * the end of the block (or of the file) is only looked for when a sentinel byte is found.
+ * Lines aren't counted while reading: current_line is only valid up to line_position and buffer_line catches up on demand.
+ * block_offset is the position of data[0] in the file, so token offsets stay absolute across refills.
+ * refills counts the blocks read, it's only kept up to date when built with LEXER_STATS.
+ * 
+ */
+typedef struct ReadBuffer {
+    FILE* fp;
+    const char* filename;
+    const uint8_t* data;
+    uint8_t content[READ_BUFFER_KEEP_SIZE + INPUT_FILE_BLOCK_SIZE + READ_BUFFER_PADDING];
+
+    size_t block_offset;
+    size_t current_position;
+    size_t total_size;
+    size_t current_line;
+    size_t line_position;
+    size_t mapped_size;
+    uint8_t* allocated;
+    int reached_eof;
+    size_t refills;
+} ReadBuffer;
+
+void init_buffer(ReadBuffer* buf, FILE* in_file, const char* in_filename);
+int init_buffer_memory(ReadBuffer* buf, const char* in_data, size_t in_size, const char* in_name);
+int buffer_is_whole(const ReadBuffer* buf);
+void init_buffer_view(ReadBuffer* buf, const ReadBuffer* source, size_t start);
+void free_buffer(ReadBuffer* buf);
+int check_sentinel(ReadBuffer* buf);
+size_t buffer_line(ReadBuffer* buf);
+
+// Hot path, inlined in the lexer
+
+/**
+ * @brief Returns the next char in the buffer AND advances the internal position tracker.
+ * If there aren't any more chars in the buffer, the file is automatically read again to refill the buffer.
+ * 
+ * @param buf Read buffer.
+ * @return Next char in the buffer, if the end of file is reached, returns EOF.
+ */
+static inline char next_char(ReadBuffer* buf) {
+    if (buf->data[buf->current_position] == READ_BUFFER_SENTINEL && !check_sentinel(buf))
+        return EOF;
+
+    // The buffer may have moved during a refill
+    return buf->data[buf->current_position++];
+}
+
+/**
+ * @brief Returns the next character in the buffer. DOES NOT advance the internal position tracker.
+ * Therefore, this function can be used to look ahead one character.
+ * If there aren't any more chars in the buffer, the file is automatically read again to refill the buffer.
+ * 
+ * @param buf Read buffer.
+ * @return Next char in the buffer, if the end of file is reached, returns EOF.
+ */
+static inline char next_char_lookup(ReadBuffer* buf) {
+    if (buf->data[buf->current_position] == READ_BUFFER_SENTINEL && !check_sentinel(buf))
+        return EOF;
+
+    return buf->data[buf->current_position];
+}
+
+/**
+ * @brief Advances the internal position tracker past the whitespace run at the current position.
+ * The run is scanned in 16/32 byte strides and stops at the first sentinel, so a run that crosses
+ * the end of a buffered block is finished one char at a time by the caller.
+ * 
+ * @param buf Read buffer.
+ */
+static inline void skip_whitespace(ReadBuffer* buf) {
+    buf->current_position += scan_whitespace(buf->data + buf->current_position);
+}
+
+/**
+ * @brief Returns the current character in the buffer. DOES NOT advance the internal position tracker.
+ * Therefore, this function can be used to lookup the current character.
+ * If there aren't any characters available, returns EOF.
+ * 
+ * @param buf Read buffer.
+ * @return Current char in the buffer or EOF as stated above.
+ */
+static inline char current_char_lookup(ReadBuffer* buf) {
+    if (buf->current_position == 0)
+        return EOF;
+
+    return buf->data[buf->current_position - 1];
+}
+
+#endif
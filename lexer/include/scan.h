@@ -0,0 +1,51 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytes that the vectorized scanners may read past the last byte they return.
+// Buffers given to these functions must be terminated by at least this many 0xFF bytes, which stop every scan.
+#define SCAN_MAX_OVERREAD   32
+
+/**
+ * @brief Finds the end of the whitespace run starting at text, using the widest SIMD instructions available.
+ * The run must be terminated by a non-whitespace byte (the ReadBuffer sentinel padding guarantees this).
+ * 
+ * @param text Start of the run.
+ * @return Length of the whitespace run, in bytes.
+ */
+size_t scan_whitespace(const uint8_t* text);
+
+/**
+ * @brief Finds the end of the run of plain string chars starting at text, using the widest SIMD instructions available.
+ * The run stops at the chars that need a closer look inside a string literal: '"', '\\', '\n', '\0' and 0xFF
+ * (the sentinel, so the ReadBuffer padding always stops it).
+ * 
+ * @param text Start of the run.
+ * @return Length of the run, in bytes.
+ */
+size_t scan_string(const uint8_t* text);
+
+/**
+ * @brief Finds the first first_stop, second_stop or 0xFF byte (the sentinel) from text on, using the widest
+ * SIMD instructions available. Used to jump over comments, so both stops may be the same byte.
+ * 
+ * @param text Start of the range.
+ * @param first_stop Byte to look for.
+ * @param second_stop Other byte to look for.
+ * @return Number of bytes before the stop.
+ */
+size_t scan_until(const uint8_t* text, uint8_t first_stop, uint8_t second_stop);
+
+/**
+ * @brief Counts the '\n' bytes in text, using the widest SIMD instructions available.
+ * Never reads past text + length.
+ * 
+ * @param text Start of the range.
+ * @param length Size of the range, in bytes.
+ * @return Number of newlines in the range.
+ */
+size_t scan_newlines(const uint8_t* text, size_t length);
+
+#endif
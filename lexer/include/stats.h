@@ -0,0 +1,75 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Counters behind --stats, only built with LEXER_STATS defined (make STATS=YES).
+// Without it every macro below is empty, so the hot paths are the same as if they weren't there
+
+#ifdef LEXER_STATS
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+
+static inline uint64_t stats_ticks(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+
+// No cycle counter, ticks are nanoseconds
+static inline uint64_t stats_ticks(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+// Only one token in STATS_SAMPLE_PERIOD has its phases timed, the others are only counted.
+// Reading the cycle counter around every phase of every token would cost about as much as the phases themselves
+#define STATS_SAMPLE_PERIOD                 64
+
+// Ticks of one stats_ticks call, taken off every lap (see stats_calibrate)
+extern uint64_t stats_tick_cost;
+
+void stats_calibrate(void);
+
+// _STATS for the first token of every STATS_SAMPLE_PERIOD, NULL for the others. _COUNTER counts the tokens
+#define STATS_SAMPLE(_STATS, _COUNTER)      ((_COUNTER)++ % STATS_SAMPLE_PERIOD == 0 ? (_STATS) : NULL)
+
+// Declares _NAME, the start of the next phase, when _STATS is timed (not NULL)
+#define STATS_START(_STATS, _NAME)          uint64_t _NAME = (_STATS) != NULL ? stats_ticks() : 0
+
+// Adds the ticks since _START (less the cost of reading them) times _WEIGHT to _STATS->_FIELD, and starts the next phase.
+// Nothing if _STATS is NULL
+#define STATS_ADD(_STATS, _FIELD, _START, _WEIGHT)                                                      \
+    do {                                                                                                \
+        if ((_STATS) != NULL) {                                                                         \
+            uint64_t _now = stats_ticks();                                                              \
+            uint64_t _lap = _now - (_START);                                                            \
+            (_STATS)->_FIELD += (_lap > stats_tick_cost ? _lap - stats_tick_cost : 0) * (_WEIGHT);      \
+            (_START) = _now;                                                                            \
+        }                                                                                               \
+    } while (0)
+
+// Lap of a sampled phase, it stands for the STATS_SAMPLE_PERIOD tokens of its sample
+#define STATS_LAP(_STATS, _FIELD, _START)   STATS_ADD(_STATS, _FIELD, _START, STATS_SAMPLE_PERIOD)
+
+// Lap of a phase that is timed every time
+#define STATS_LAP_ONCE(_STATS, _FIELD, _START)  STATS_ADD(_STATS, _FIELD, _START, 1)
+
+#define STATS_COUNT(_COUNTER)               ((_COUNTER)++)
+
+#else
+
+#define STATS_SAMPLE(_STATS, _COUNTER)      NULL
+#define STATS_START(_STATS, _NAME)
+#define STATS_LAP(_STATS, _FIELD, _START)   ((void)(_STATS))
+#define STATS_LAP_ONCE(_STATS, _FIELD, _START)  ((void)(_STATS))
+#define STATS_COUNT(_COUNTER)               ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "token.h"
+
+// Constants
+#define SYMBOL_TABLE_MIN_SLOTS      256
+
+/**
+ * @brief Symbol struct.
+ * One interned name, its id is its index in the table.
+ * 
+ */
+typedef struct Symbol {
+    const char* text;
+    size_t size;
+    uint64_t hash;
+} Symbol;
+
+/**
+ * @brief SymbolSlot struct.
+ * Slot of the hash index. id is the symbol id plus one, 0 marks an empty slot.
+ * tag is the high half of the hash, so most mismatches are found without touching the text.
+ * 
+ */
+typedef struct SymbolSlot {
+    uint32_t tag;
+    uint32_t id;
+} SymbolSlot;
+
+/**
+ * @brief SymbolTable struct.
+ * Interns names into dense ids (0, 1, 2...) given in order of first appearance.
+ * The index is open addressed with linear probing and kept at most half full.
+ * A zeroed table is empty and ready to use. When out of memory symbol_intern returns TOKEN_NO_SYMBOL
+ * and sets failed, the table is left as it was.
+ * 
+ */
+typedef struct SymbolTable {
+    SymbolSlot* slots;
+    size_t slot_count;
+    Symbol* symbols;
+    uint32_t count;
+    uint32_t capacity;
+    int failed;
+} SymbolTable;
+
+uint64_t symbol_hash(const char* text, size_t size);
+uint32_t symbol_intern(SymbolTable* table, Arena* arena, const char* text, size_t size, uint64_t hash);
+void symbol_table_free(SymbolTable* table);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The library is built with hidden symbols, only what is marked LEXER_API is exported from liblexer
+#define LEXER_API                   __attribute__((visibility("default")))
+
+/**
+ * @brief Every kind of token the lexer produces.
+ * Keywords and terminals have no text, the kinds from TOKEN_IDENTIFIER to TOKEN_ERROR do.
+ * TOKEN_ERROR is the offending input of a lexical error, the error itself is in the lexer diagnostics.
+ * 
+ */
+typedef enum TokenKind {
+    TOKEN_NONE,
+    TOKEN_EOF,
+
+    // Tokens with text
+    TOKEN_IDENTIFIER,
+    TOKEN_TYPE,
+    TOKEN_INTEGER,
+    TOKEN_STRING,
+    TOKEN_ERROR,
+
+    // Keywords
+    TOKEN_CLASS,
+    TOKEN_ELSE,
+    TOKEN_FALSE,
+    TOKEN_FI,
+    TOKEN_IF,
+    TOKEN_IN,
+    TOKEN_INHERITS,
+    TOKEN_ISVOID,
+    TOKEN_LET,
+    TOKEN_LOOP,
+    TOKEN_POOL,
+    TOKEN_THEN,
+    TOKEN_WHILE,
+    TOKEN_CASE,
+    TOKEN_ESAC,
+    TOKEN_NEW,
+    TOKEN_OF,
+    TOKEN_NOT,
+    TOKEN_TRUE,
+
+    // Terminals
+    TOKEN_LPAREN,
+    TOKEN_RPAREN,
+    TOKEN_TIMES,
+    TOKEN_PLUS,
+    TOKEN_COMMA,
+    TOKEN_MINUS,
+    TOKEN_DOT,
+    TOKEN_DIVIDE,
+    TOKEN_COLON,
+    TOKEN_SEMI,
+    TOKEN_LARROW,
+    TOKEN_LE,
+    TOKEN_LT,
+    TOKEN_RARROW,
+    TOKEN_EQUALS,
+    TOKEN_AT,
+    TOKEN_LBRACE,
+    TOKEN_RBRACE,
+    TOKEN_TILDE,
+
+    TOKEN_KIND_COUNT
+} TokenKind;
+
+#define TOKEN_HAS_TEXT(_KIND)       ((_KIND) >= TOKEN_IDENTIFIER && (_KIND) <= TOKEN_ERROR)
+#define TOKEN_HAS_SYMBOL(_KIND)     ((_KIND) == TOKEN_IDENTIFIER || (_KIND) == TOKEN_TYPE)
+
+// Symbol of the tokens that carry neither a symbol nor a value
+#define TOKEN_NO_SYMBOL             UINT32_MAX
+
+/**
+ * @brief Token struct.
+ * Only positions are stored, the text of a token is the span [offset, offset + length) of the source.
+ * For strings the span includes the quotes.
+ * Identifiers and types also carry the id of their name in the lexer symbol table (as.symbol), so equal names have
+ * equal ids. Integers carry their value instead (as.value), so it never needs to be parsed again.
+ * The union is named so the header stays valid C99.
+ * 
+ */
+typedef struct Token {
+    size_t offset;
+    uint32_t length;
+    uint32_t line;
+    union {
+        uint32_t symbol;
+        int32_t value;
+    } as;
+    uint8_t kind;
+} Token;
+
+// Names used by the text output (.cl-lex) and their sizes, indexed by TokenKind
+LEXER_API extern const char* const token_kind_names[TOKEN_KIND_COUNT];
+LEXER_API extern const uint8_t token_kind_name_sizes[TOKEN_KIND_COUNT];
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ * @brief Starts a new page with room for at least size bytes and makes it the current one.
+ * The rest of the previous page is left unused.
+ * 
+ * @param arena Arena.
+ * @param size Bytes needed.
+ * @return 1 on success, 0 if out of memory (the current page stays the same).
+ */
+static int arena_new_page(Arena* arena, size_t size) {
+    size_t page_size = size > ARENA_PAGE_SIZE ? size : ARENA_PAGE_SIZE;
+    ArenaPage* page = malloc(sizeof(ArenaPage) + page_size);
+
+    if (page == NULL)
+        return 0;
+
+    page->next = arena->pages;
+    arena->pages = page;
+    arena->position = page->data;
+    arena->end = page->data + page_size;
+    return 1;
+}
+
+/**
+ * @brief Makes room for size bytes for the text being built at the current position.
+ * If the page is too small, the used bytes are moved to a new page of at least twice the size,
+ * so a growing text is copied O(1) times on average whatever its final size.
+ * 
+ * @param arena Arena.
+ * @param used Bytes of the text already written, kept if it moves.
+ * @param size Bytes needed for the text, at least used.
+ * @param capacity Receives the bytes available for the text, at least size.
+ * @return Start of the text, it may have moved. NULL if out of memory.
+ */
+char* arena_reserve(Arena* arena, size_t used, size_t size, size_t* capacity) {
+    if ((size_t)(arena->end - arena->position) < size) {
+        char* old_text = arena->position;
+
+        if (!arena_new_page(arena, 2 * size))
+            return NULL;
+
+        if (used > 0)
+            memcpy(arena->position, old_text, used);
+    }
+
+    *capacity = arena->end - arena->position;
+    return arena->position;
+}
+
+/**
+ * @brief Allocates size bytes (not aligned, for texts).
+ * 
+ * @param arena Arena.
+ * @param size Bytes needed.
+ * @return The bytes, valid until arena_free. NULL if out of memory.
+ */
+char* arena_alloc(Arena* arena, size_t size) {
+    if ((size_t)(arena->end - arena->position) < size && !arena_new_page(arena, size))
+        return NULL;
+
+    char* bytes = arena->position;
+    arena->position += size;
+
+    return bytes;
+}
+
+/**
+ * @brief Frees every page at once. The arena is left empty and may be used again.
+ * 
+ * @param arena Arena.
+ */
+void arena_free(Arena* arena) {
+    while (arena->pages != NULL) {
+        ArenaPage* next = arena->pages->next;
+
+        free(arena->pages);
+        arena->pages = next;
+    }
+
+    arena->position = NULL;
+    arena->end = NULL;
+}
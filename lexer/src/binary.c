@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary.h"
+#include "lexer_internal.h"
+
+/**
+ * @brief Encodes value as a varint.
+ * 
+ * @param dest Where the bytes are written, needs room for BINARY_MAX_VARINT_SIZE bytes.
+ * @param value Number to encode.
+ * @return Pointer past the last byte written.
+ */
+static uint8_t* encode_varint(uint8_t* dest, uint64_t value) {
+    while (value >= 0x80) {
+        *dest++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+
+    *dest++ = (uint8_t)value;
+    return dest;
+}
+
+/**
+ * @brief Decodes the varint at the reader position and advances past it.
+ * 
+ * @param reader Binary reader.
+ * @param value Receives the number.
+ * @return 1 on success, 0 if the stream ends in the middle of the varint or the varint is too long.
+ */
+static int decode_varint(BinaryReader* reader, uint64_t* value) {
+    *value = 0;
+
+    for (int shift = 0; shift < 7 * BINARY_MAX_VARINT_SIZE; shift += 7) {
+        if (reader->position == reader->size)
+            return 0;
+
+        uint8_t byte = reader->data[reader->position++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes the magic and the format version and prepares to write tokens.
+ * 
+ * @param writer Binary writer to initialize.
+ * @param out Output buffer, nothing must have been written to it yet.
+ */
+void binary_writer_init(BinaryWriter* writer, OutputBuffer* out) {
+    *writer = (BinaryWriter){.out = out, .line = 0, .symbol_count = 0};
+
+    output_write(out, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    output_write(out, &(uint8_t){BINARY_VERSION}, 1);
+}
+
+/**
+ * @brief Writes a token record. The TOKEN_EOF token must be written too, it marks the end of the stream.
+ * Tokens must be written in order, so symbols are seen in the order the lexer numbered them.
+ * 
+ * @param writer Binary writer.
+ * @param token Token to write.
+ * @param text Text of the token, ignored for keywords, terminals and symbols already written.
+ * @param text_size Size of text.
+ */
+void write_token_binary(BinaryWriter* writer, const Token* token, const char* text, size_t text_size) {
+    OutputBuffer* out = writer->out;
+    uint8_t* dest = (uint8_t*)output_reserve(out, 1 + 3 * BINARY_MAX_VARINT_SIZE);
+    uint8_t* start = dest;
+    int has_text = TOKEN_HAS_TEXT(token->kind);
+
+    *dest++ = token->kind;
+    dest = encode_varint(dest, token->line - writer->line);
+
+    if (TOKEN_HAS_SYMBOL(token->kind)) {
+        dest = encode_varint(dest, token->as.symbol);
+
+        if (token->as.symbol == writer->symbol_count)
+            writer->symbol_count++;
+        else
+            has_text = 0;
+    }
+
+    if (has_text)
+        dest = encode_varint(dest, text_size);
+
+    out->used += dest - start;
+
+    if (has_text)
+        output_write(out, text, text_size);
+
+    writer->line = token->line;
+}
+
+int binary_reader_init(BinaryReader* reader, const uint8_t* data, size_t size) {
+    if (size < BINARY_HEADER_SIZE || memcmp(data, BINARY_MAGIC, BINARY_MAGIC_SIZE) != 0)
+        return 0;
+
+    if (data[BINARY_MAGIC_SIZE] != BINARY_VERSION)
+        return 0;
+
+    reader->data = data;
+    reader->size = size;
+    reader->position = BINARY_HEADER_SIZE;
+    reader->line = 0;
+    reader->symbols = NULL;
+    reader->symbol_count = 0;
+    reader->symbol_capacity = 0;
+    return 1;
+}
+
+/**
+ * @brief Reads the symbol id of an identifier or type, and its text if it's a new one.
+ * 
+ * @return 1 on success, 0 if the stream is malformed or truncated, or out of memory.
+ */
+static int read_symbol(BinaryReader* reader, Token* token, const char** text, uint64_t* size) {
+    uint64_t symbol;
+
+    if (!decode_varint(reader, &symbol) || symbol > reader->symbol_count)
+        return 0;
+
+    if (symbol == reader->symbol_count) {
+        if (!decode_varint(reader, size) || *size > reader->size - reader->position || symbol == TOKEN_NO_SYMBOL)
+            return 0;
+
+        if (reader->symbol_count == reader->symbol_capacity) {
+            uint32_t capacity = reader->symbol_capacity == 0 ? 256 : reader->symbol_capacity * 2;
+            BinarySymbol* symbols = realloc(reader->symbols, capacity * sizeof(BinarySymbol));
+
+            if (symbols == NULL)
+                return 0;
+
+            reader->symbols = symbols;
+            reader->symbol_capacity = capacity;
+        }
+
+        reader->symbols[reader->symbol_count++] = (BinarySymbol){
+            .text = (const char*)reader->data + reader->position,
+            .size = *size
+        };
+
+        reader->position += *size;
+    }
+
+    token->as.symbol = symbol;
+    *text = reader->symbols[symbol].text;
+    *size = reader->symbols[symbol].size;
+    return 1;
+}
+
+int binary_read_token(BinaryReader* reader, Token* token, const char** text, size_t* text_size) {
+    uint64_t line_delta, size = 0;
+
+    if (reader->position == reader->size)
+        return -1;
+
+    token->kind = reader->data[reader->position++];
+
+    if (token->kind == TOKEN_NONE || token->kind >= TOKEN_KIND_COUNT || !decode_varint(reader, &line_delta))
+        return -1;
+
+    reader->line += line_delta;
+
+    token->line = reader->line;
+    token->offset = 0;
+    token->length = 0;
+    token->as.symbol = TOKEN_NO_SYMBOL;
+
+    *text = NULL;
+
+    if (TOKEN_HAS_SYMBOL(token->kind)) {
+        if (!read_symbol(reader, token, text, &size))
+            return -1;
+    } else if (TOKEN_HAS_TEXT(token->kind)) {
+        if (!decode_varint(reader, &size) || size > reader->size - reader->position)
+            return -1;
+
+        *text = (const char*)reader->data + reader->position;
+        reader->position += size;
+
+        // The value isn't stored, the digits are
+        if (token->kind == TOKEN_INTEGER && !parse_integer(*text, size, &token->as.value))
+            return -1;
+    }
+
+    *text_size = size;
+
+    return token->kind != TOKEN_EOF;
+}
+
+void binary_reader_free(BinaryReader* reader) {
+    free(reader->symbols);
+    reader->symbols = NULL;
+    reader->symbol_count = 0;
+    reader->symbol_capacity = 0;
+}
@@ -0,0 +1,30 @@
+#include "charclass.h"
+
+// Shorthands for the table below
+#define W   CHAR_CLASS_WHITESPACE
+#define T   CHAR_CLASS_TERMINAL_START
+#define D   (CHAR_CLASS_DIGIT | CHAR_CLASS_NAME)
+#define L   (CHAR_CLASS_NAME_START | CHAR_CLASS_NAME)
+
+// Everything not listed (including EOF, as 0xFF) has no class
+const uint8_t char_classes[256] = {
+    // Whitespace
+    [' '] = W, ['\t'] = W, ['\n'] = W, ['\v'] = W, ['\f'] = W, ['\r'] = W,
+
+    // Strings
+    ['"'] = CHAR_CLASS_STRING_START,
+
+    // Operators and punctuation
+    ['('] = T, [')'] = T, ['*'] = T, ['+'] = T, [','] = T, ['-'] = T, ['.'] = T, ['/'] = T, [':'] = T,
+    [';'] = T, ['<'] = T, ['='] = T, ['@'] = T, ['{'] = T, ['}'] = T, ['~'] = T,
+
+    // Digits
+    ['0'] = D, ['1'] = D, ['2'] = D, ['3'] = D, ['4'] = D, ['5'] = D, ['6'] = D, ['7'] = D, ['8'] = D, ['9'] = D,
+
+    // Letters and underscore
+    ['A'] = L, ['B'] = L, ['C'] = L, ['D'] = L, ['E'] = L, ['F'] = L, ['G'] = L, ['H'] = L, ['I'] = L, ['J'] = L, ['K'] = L, ['L'] = L, ['M'] = L,
+    ['N'] = L, ['O'] = L, ['P'] = L, ['Q'] = L, ['R'] = L, ['S'] = L, ['T'] = L, ['U'] = L, ['V'] = L, ['W'] = L, ['X'] = L, ['Y'] = L, ['Z'] = L,
+    ['a'] = L, ['b'] = L, ['c'] = L, ['d'] = L, ['e'] = L, ['f'] = L, ['g'] = L, ['h'] = L, ['i'] = L, ['j'] = L, ['k'] = L, ['l'] = L, ['m'] = L,
+    ['n'] = L, ['o'] = L, ['p'] = L, ['q'] = L, ['r'] = L, ['s'] = L, ['t'] = L, ['u'] = L, ['v'] = L, ['w'] = L, ['x'] = L, ['y'] = L, ['z'] = L,
+    ['_'] = L,
+};
@@ -0,0 +1,59 @@
+#include <stdint.h>
+
+#include "keyword.h"
+
+#define KEYWORD_MAX_LENGTH      8
+#define KEYWORD_TABLE_SIZE      32
+
+// Lowercase for ASCII letters. Other chars may map to anything, they never match a keyword anyway
+#define KEYWORD_LOWER(_C)       ((uint8_t)(_C) | 0x20)
+
+// Perfect hash for the 19 keywords, found by brute force over small multipliers
+#define KEYWORD_HASH(_FIRST, _LAST, _LENGTH) \
+    ((KEYWORD_LOWER(_FIRST) * 2 + KEYWORD_LOWER(_LAST) * 13 + (_LENGTH) * 3) & (KEYWORD_TABLE_SIZE - 1))
+
+typedef struct Keyword {
+    const char* text;
+    size_t length;
+    TokenKind kind;
+} Keyword;
+
+// Indexed by KEYWORD_HASH, empty slots have length 0
+static const Keyword keyword_table[KEYWORD_TABLE_SIZE] = {
+    [1]  = {"inherits", 8, TOKEN_INHERITS},
+    [5]  = {"let", 3, TOKEN_LET},
+    [6]  = {"if", 2, TOKEN_IF},
+    [7]  = {"fi", 2, TOKEN_FI},
+    [8]  = {"pool", 4, TOKEN_POOL},
+    [9]  = {"not", 3, TOKEN_NOT},
+    [10] = {"then", 4, TOKEN_THEN},
+    [12] = {"class", 5, TOKEN_CLASS},
+    [14] = {"in", 2, TOKEN_IN},
+    [16] = {"new", 3, TOKEN_NEW},
+    [18] = {"of", 2, TOKEN_OF},
+    [19] = {"case", 4, TOKEN_CASE},
+    [20] = {"loop", 4, TOKEN_LOOP},
+    [21] = {"true", 4, TOKEN_TRUE},
+    [23] = {"else", 4, TOKEN_ELSE},
+    [24] = {"isvoid", 6, TOKEN_ISVOID},
+    [28] = {"false", 5, TOKEN_FALSE},
+    [29] = {"esac", 4, TOKEN_ESAC},
+    [30] = {"while", 5, TOKEN_WHILE},
+};
+
+TokenKind check_keyword(const char* text, size_t length) {
+    if (length == 0 || length > KEYWORD_MAX_LENGTH)
+        return TOKEN_IDENTIFIER;
+
+    const Keyword* keyword = &keyword_table[KEYWORD_HASH(text[0], text[length - 1], length)];
+
+    if (keyword->length != length)
+        return TOKEN_IDENTIFIER;
+
+    // Single case insensitive pass, keywords are stored in lowercase
+    for (size_t i = 0; i < length; i++)
+        if (KEYWORD_LOWER(text[i]) != (uint8_t)keyword->text[i])
+            return TOKEN_IDENTIFIER;
+
+    return keyword->kind;
+}
@@ -0,0 +1,900 @@
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "charclass.h"
+#include "keyword.h"
+#include "lexer.h"
+#include "lexer_internal.h"
+#include "read_buffer.h"
+#include "scan.h"
+#include "stats.h"
+#include "symbol.h"
+#include "token.h"
+
+/**
+ * @brief Adds a lexical error to diagnostics, on the current line of read_buffer.
+ * 
+ * @param diagnostics Where the error goes, NULL to ignore it.
+ * @param read_buffer Read buffer.
+ * @param code One of the LEXER_ERROR codes.
+ * @param hint Static hint shown after the message, or NULL.
+ * @param format printf format of the message.
+ */
+static void add_diagnostic(DiagnosticList* diagnostics, ReadBuffer* read_buffer, int code, const char* hint, const char* format, ...) {
+    if (diagnostics == NULL)
+        return;
+
+    if (diagnostics->status == LEXER_OK)
+        diagnostics->status = code;
+
+    if (diagnostics->count == diagnostics->capacity) {
+        size_t capacity = diagnostics->capacity == 0 ? 16 : diagnostics->capacity * 2;
+        LexerDiagnostic* items = realloc(diagnostics->items, capacity * sizeof(LexerDiagnostic));
+
+        if (items == NULL)
+            return;
+
+        diagnostics->items = items;
+        diagnostics->capacity = capacity;
+    }
+
+    va_list args;
+
+    va_start(args, format);
+    int size = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    char* message = size < 0 ? NULL : malloc(size + 1);
+
+    if (message == NULL)
+        return;
+
+    va_start(args, format);
+    vsnprintf(message, size + 1, format, args);
+    va_end(args);
+
+    diagnostics->items[diagnostics->count++] = (LexerDiagnostic){
+        .code = code,
+        .line = buffer_line(read_buffer),
+        .message = message,
+        .message_size = size,
+        .hint = hint,
+    };
+}
+
+/**
+ * @brief Moves every diagnostic of src to the end of dest, leaving src empty.
+ * 
+ * @param dest Diagnostic list that receives them.
+ * @param src Diagnostic list that gives them.
+ * @param line_shift Added to the line of every diagnostic.
+ */
+void move_diagnostics(DiagnosticList* dest, DiagnosticList* src, size_t line_shift) {
+    if (dest->status == LEXER_OK)
+        dest->status = src->status;
+
+    for (size_t i = 0; i < src->count; i++) {
+        if (dest->count == dest->capacity) {
+            size_t capacity = dest->capacity == 0 ? 16 : dest->capacity * 2;
+            LexerDiagnostic* items = realloc(dest->items, capacity * sizeof(LexerDiagnostic));
+
+            // Out of memory, the status is kept anyway
+            if (items == NULL) {
+                free(src->items[i].message);
+                continue;
+            }
+
+            dest->items = items;
+            dest->capacity = capacity;
+        }
+
+        dest->items[dest->count] = src->items[i];
+        dest->items[dest->count++].line += line_shift;
+    }
+
+    src->count = 0;
+    src->status = LEXER_OK;
+}
+
+/**
+ * @brief Reports that lexing can't go on because memory ran out. The status becomes LEXER_ERROR_OUT_OF_MEMORY
+ * whatever the errors before, since the tokens after this point are missing.
+ * 
+ * @param diagnostics Where the error goes, NULL to ignore it.
+ * @param read_buffer Read buffer.
+ */
+void report_out_of_memory(DiagnosticList* diagnostics, ReadBuffer* read_buffer) {
+    if (diagnostics == NULL)
+        return;
+
+    diagnostics->failed = 1;
+    diagnostics->status = LEXER_ERROR_OUT_OF_MEMORY;
+    add_diagnostic(diagnostics, read_buffer, LEXER_ERROR_OUT_OF_MEMORY, NULL, "out of memory, lexing stopped here");
+}
+
+void free_diagnostics(DiagnosticList* diagnostics) {
+    for (size_t i = 0; i < diagnostics->count; i++)
+        free(diagnostics->items[i].message);
+
+    free(diagnostics->items);
+    *diagnostics = (DiagnosticList){0};
+}
+
+int iswhitespace(char c) {
+    return CHAR_IS(c, CHAR_CLASS_WHITESPACE) != 0;
+}
+
+static int isname(char c) {
+    return CHAR_IS(c, CHAR_CLASS_NAME) != 0;
+}
+
+/**
+ * @brief Text of the source span from start to the current position.
+ * When the whole input is in memory it's a pointer into it, otherwise the span is copied to the arena.
+ * 
+ * @param read_buffer Read buffer, the span must still be in its data.
+ * @param arena Arena for the copy.
+ * @param start Position of the span in data.
+ * @return The text, not null terminated. NULL if out of memory.
+ */
+static const char* source_text(ReadBuffer* read_buffer, Arena* arena, size_t start) {
+    const char* span = (const char*)read_buffer->data + start;
+
+    if (buffer_is_whole(read_buffer))
+        return span;
+
+    size_t size = read_buffer->current_position - start;
+    char* copy = arena_alloc(arena, size);
+
+    if (copy != NULL)
+        memcpy(copy, span, size);
+
+    return copy;
+}
+
+/**
+ * @brief Reads the rest of an identifier, type, keyword or integer. Names have no length limit.
+ * When the whole input is in memory the name is never copied, the text is its span in the input.
+ * 
+ * @param read_buffer Read buffer, positioned just after the first char of the name.
+ * @param arena Arena that receives the name when the input is read in blocks.
+ * @param text Receives the name, not null terminated. NULL if out of memory, the name is read anyway.
+ * @return Size of the name.
+ */
+static size_t extract_general_name(ReadBuffer* read_buffer, Arena* arena, const char** text) {
+    size_t start = read_buffer->current_position - 1;
+
+    // The sentinel isn't a name char, so the end of the input stops the scan too
+    if (buffer_is_whole(read_buffer)) {
+        const uint8_t* data = read_buffer->data;
+        size_t position = read_buffer->current_position;
+
+        while (isname(data[position]))
+            position++;
+
+        read_buffer->current_position = position;
+
+        *text = (const char*)data + start;
+        return position - start;
+    }
+
+    // Blocks may be refilled in the middle of the name, so it's copied as it's read
+    size_t capacity;
+    char* name = arena_reserve(arena, 0, 1, &capacity);
+
+    // Get char that triggered this function call
+    if (name != NULL)
+        name[0] = current_char_lookup(read_buffer);
+
+    size_t size = 1;
+
+    while (isname(next_char_lookup(read_buffer))) {
+        if (name != NULL && size == capacity)
+            name = arena_reserve(arena, size, size + 1, &capacity);
+
+        char c = next_char(read_buffer);
+
+        if (name != NULL)
+            name[size] = c;
+
+        size++;
+    }
+
+    if (name != NULL)
+        arena_commit(arena, size);
+
+    *text = name;
+    return size;
+}
+
+/**
+ * @brief Reads the rest of a string literal. After an error the string is still read up to its end,
+ * so lexing goes on from the same place whatever went wrong: the closing quote, a non-escaped newline (left unread)
+ * or EOF. Null chars are dropped. Strings longer than LITERAL_STRING_MAX_SIZE are an error but are kept whole.
+ * When the whole input is in memory, the contents are only copied to the arena if some char has to be left out
+ * (escaped newlines and null chars), otherwise the text is their span in the input.
+ * 
+ * @param read_buffer Read buffer, positioned just after the opening quote.
+ * @param arena Arena that receives the contents when they are copied.
+ * @param text Receives the contents, without quotes and escaped newlines, not null terminated.
+ * NULL if out of memory, the string is read anyway.
+ * @param text_size Receives the size of the contents.
+ * @param diagnostics Receives the first error, if any.
+ * @return LEXER_OK or the LEXER_ERROR code of the first error. LEXER_ERROR_OUT_OF_MEMORY is returned
+ * but not added to diagnostics, that's left to the caller.
+ */
+int extract_string(ReadBuffer* read_buffer, Arena* arena, const char** text, size_t* text_size, DiagnosticList* diagnostics) {
+    // The contents are a span of the input until a char is left out, then they are copied to the arena
+    const char* span = (const char*)read_buffer->data + read_buffer->current_position;
+    char* contents = NULL;
+    size_t capacity = 0;
+    size_t size = 0;
+    int status = LEXER_OK;
+    int out_of_memory = 0;
+
+    if (!buffer_is_whole(read_buffer)) {
+        contents = arena_reserve(arena, 0, 1, &capacity);
+        out_of_memory = contents == NULL;
+    }
+
+    while (1) {
+        // Plain chars are taken in bulk. The last one of the run is left to the loop below,
+        // since the char after it (a newline maybe) decides what happens to it
+        size_t run = scan_string(read_buffer->data + read_buffer->current_position);
+
+        if (run > 1) {
+            run--;
+
+            if (size + run > LITERAL_STRING_MAX_SIZE && status == LEXER_OK) {
+                status = LEXER_ERROR_STRING_LITERAL_TOO_LONG;
+                add_diagnostic(diagnostics, read_buffer, status, NULL,
+                               "literal string too long (max %d chars allowed)",
+                               LITERAL_STRING_MAX_SIZE);
+            }
+
+            if (contents != NULL && size + run > capacity) {
+                contents = arena_reserve(arena, size, size + run, &capacity);
+                out_of_memory = contents == NULL;
+            }
+
+            if (contents != NULL)
+                memcpy(contents + size, read_buffer->data + read_buffer->current_position, run);
+
+            read_buffer->current_position += run;
+            size += run;
+        }
+
+        char previous_char = current_char_lookup(read_buffer);
+        char current_char = next_char(read_buffer);
+
+        // Check end of string (also works for empty strings)
+        // TODO: Fix bug when string is "anything\\"
+        if (previous_char != '\\' && current_char == '\"')
+            break;
+
+        // Check invalid
+        if (current_char == '\0' || current_char == EOF) {
+            if (status == LEXER_OK) {
+                status = LEXER_ERROR_INVALID_STRING_CHARACTER;
+                add_diagnostic(diagnostics, read_buffer, status, NULL,
+                               "literal string may not contain null character or EOF");
+            }
+
+            if (current_char == EOF)
+                break;
+        }
+
+        // Multiline string
+        int unterminated = 0;
+        int left_out = current_char == '\0';
+
+        if (next_char_lookup(read_buffer) == '\n') {
+            if (current_char == '\\') {
+                // Consume end of line
+                next_char(read_buffer);
+                left_out = 1;
+            } else {
+                // Incorrect multiline, the string ends here and lexing goes on in the next line
+                unterminated = 1;
+
+                if (status == LEXER_OK) {
+                    status = LEXER_ERROR_NON_ESCAPED_NEWLINE;
+                    add_diagnostic(diagnostics, read_buffer, status, "add \\ before newline or close this string with \"",
+                                   "non-escaped newline character inside literal string.");
+                }
+            }
+        }
+
+        // From here on the contents aren't a span of the input anymore
+        if (left_out) {
+            if (contents == NULL && !out_of_memory) {
+                contents = arena_reserve(arena, 0, size + 1, &capacity);
+                out_of_memory = contents == NULL;
+
+                if (contents != NULL)
+                    memcpy(contents, span, size);
+            }
+
+            continue;
+        }
+
+        // Valid char
+        if (size == LITERAL_STRING_MAX_SIZE && status == LEXER_OK) {
+            status = LEXER_ERROR_STRING_LITERAL_TOO_LONG;
+            add_diagnostic(diagnostics, read_buffer, status, NULL,
+                           "literal string too long (max %d chars allowed)",
+                           LITERAL_STRING_MAX_SIZE);
+        }
+
+        if (contents != NULL && size == capacity) {
+            contents = arena_reserve(arena, size, size + 1, &capacity);
+            out_of_memory = contents == NULL;
+        }
+
+        if (contents != NULL)
+            contents[size] = current_char;
+
+        size++;
+
+        if (unterminated)
+            break;
+    }
+
+    // The string is read to its end anyway, so the position is the same as without the error
+    if (out_of_memory) {
+        *text = NULL;
+        *text_size = 0;
+        return LEXER_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (contents != NULL) {
+        arena_commit(arena, size);
+        span = contents;
+    }
+
+    *text = span;
+    *text_size = size;
+    return status;
+}
+
+TokenKind extract_terminal(ReadBuffer* read_buffer) {
+    // Kinds of the single char terminals
+    static const uint8_t terminal_kinds[256] = {
+        ['('] = TOKEN_LPAREN, [')'] = TOKEN_RPAREN, ['*'] = TOKEN_TIMES, ['+'] = TOKEN_PLUS, [','] = TOKEN_COMMA,
+        ['-'] = TOKEN_MINUS, ['.'] = TOKEN_DOT, ['/'] = TOKEN_DIVIDE, [':'] = TOKEN_COLON, [';'] = TOKEN_SEMI,
+        ['<'] = TOKEN_LT, ['='] = TOKEN_EQUALS, ['@'] = TOKEN_AT, ['{'] = TOKEN_LBRACE, ['}'] = TOKEN_RBRACE, ['~'] = TOKEN_TILDE,
+    };
+
+    // Get char that triggered this function call
+    char current_char = current_char_lookup(read_buffer);
+
+    if (!CHAR_IS(current_char, CHAR_CLASS_TERMINAL_START))
+        return TOKEN_NONE;
+
+    // Only '<' and '=' may start a two char terminal
+    switch (current_char) {
+    case '<':
+        switch (next_char_lookup(read_buffer)) {
+        case '-':
+            next_char(read_buffer);
+            return TOKEN_LARROW;
+            break;
+        
+        case '=':
+            next_char(read_buffer);
+            return TOKEN_LE;
+            break;
+        }
+        break;
+
+    case '=':
+        if (next_char_lookup(read_buffer) == '>') {
+            next_char(read_buffer);
+            return TOKEN_RARROW;
+        }
+        break;
+    }
+
+    return terminal_kinds[(uint8_t)current_char];
+}
+
+/**
+ * @brief Tells if the 8 chars of word are all digits.
+ * 
+ */
+static inline int swar_all_digits(uint64_t word) {
+    // Digits are 0x30 to 0x39: high nibble 3, and adding 6 doesn't carry into the high nibble
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL) | (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+/**
+ * @brief Converts 8 digits to their value, the first digit in the lowest byte (little endian load).
+ * Each step merges pairs of neighbour lanes: digits into 2-digit numbers, then 4, then 8.
+ * 
+ */
+static inline uint32_t swar_parse_digits(uint64_t word) {
+    word = ((word & 0x0F0F0F0F0F0F0F0FULL) * (10 << 8 | 1)) >> 8;
+    word = ((word & 0x00FF00FF00FF00FFULL) * (100 << 16 | 1)) >> 16;
+    return ((word & 0x0000FFFF0000FFFFULL) * (10000ULL << 32 | 1)) >> 32;
+}
+
+/**
+ * @brief Loads 1 to 8 chars into a word, right aligned and padded with leading '0's, without reading past them.
+ * Sizes that aren't a power of two are loaded with two overlapping loads, so no variable size memcpy is needed.
+ * 
+ */
+static inline uint64_t swar_load_digits(const char* text, size_t size) {
+    uint64_t word;
+
+    if (size == 8) {
+        memcpy(&word, text, 8);
+        return word;
+    }
+
+    if (size >= 4) {
+        uint32_t low, high;
+
+        memcpy(&low, text, 4);
+        memcpy(&high, text + size - 4, 4);
+        word = low | (uint64_t)high << (8 * (size - 4));
+    } else {
+        word = (uint8_t)text[0] | (uint64_t)(uint8_t)text[size / 2] << (8 * (size / 2)) |
+               (uint64_t)(uint8_t)text[size - 1] << (8 * (size - 1));
+    }
+
+    return word << (8 * (8 - size)) | 0x3030303030303030ULL >> (8 * size);
+}
+
+/**
+ * @brief Checks that text is a positive 32-bit signed integer (at most 10 digits, up to INT32_MAX) and converts it.
+ * The last 8 digits are checked and converted 8 at a time in one register (SWAR), shorter texts are padded with
+ * leading zeros, and at most 2 leading digits are left for a plain loop.
+ * 
+ * @param text Digits, not null terminated.
+ * @param text_size Size of text.
+ * @param value Receives the value if it's valid.
+ * @return 1 if text is a valid integer, 0 otherwise.
+ */
+int parse_integer(const char* text, size_t text_size, int32_t* value) {
+    if (text_size == 0 || text_size > 10)
+        return 0;
+
+    size_t head_size = text_size > 8 ? text_size - 8 : 0;
+    uint64_t word = swar_load_digits(text + head_size, text_size - head_size);
+
+    if (!swar_all_digits(word))
+        return 0;
+
+    uint64_t head = 0;
+
+    for (size_t i = 0; i < head_size; i++) {
+        if (!CHAR_IS(text[i], CHAR_CLASS_DIGIT))
+            return 0;
+
+        head = head * 10 + (text[i] - '0');
+    }
+
+    uint64_t number = head * 100000000 + swar_parse_digits(word);
+
+    if (number > INT32_MAX)
+        return 0;
+
+    *value = (int32_t)number;
+    return 1;
+}
+
+/**
+ * @brief Skips the rest of a (* *) comment. Comments nest, so every "(*" inside it needs its own "*)".
+ * Only '*' and '(' chars can change the depth, so the chars in between are jumped over with scan_until.
+ * Their newlines are counted later, in bulk, by buffer_line.
+ * 
+ * @param read_buffer Read buffer, positioned just after the "(*" that opened the comment, or anywhere inside it.
+ * @param depth Number of comments open at the current position.
+ * @param end Position where skipping stops even if the comment is still open. SIZE_MAX to skip to the end of the comment.
+ * @return Number of comments still open: 0 once the last "*)" is read, more if end or EOF came first.
+ */
+size_t skip_block_comment(ReadBuffer* read_buffer, size_t depth, size_t end) {
+    while (depth > 0) {
+        // Stops at sentinels too, so refills and EOF are still handled by next_char
+        read_buffer->current_position += scan_until(read_buffer->data + read_buffer->current_position, '*', '(');
+
+        if (read_buffer->current_position >= end)
+            break;
+
+        char current_char = next_char(read_buffer);
+
+        if (current_char == EOF)
+            break;
+
+        if (current_char == '*' && next_char_lookup(read_buffer) == ')') {
+            next_char(read_buffer);
+            depth--;
+        } else if (current_char == '(' && next_char_lookup(read_buffer) == '*') {
+            next_char(read_buffer);
+            depth++;
+        }
+    }
+
+    return depth;
+}
+
+int remove_comments(ReadBuffer* read_buffer) {
+    // Get current char again (we are not inside the main while loop)
+    char current_char = current_char_lookup(read_buffer);
+
+    // Handling one line comments, jumping straight to the newline
+    if (current_char == '-' && next_char_lookup(read_buffer) == '-') {
+        do {
+            read_buffer->current_position += scan_until(read_buffer->data + read_buffer->current_position, '\n', '\n');
+            current_char = next_char(read_buffer);
+        } while (current_char != '\n' && current_char != EOF);
+
+        return 1;
+    }
+
+    // Handling multiple line comments, the '*' of "(*" can't close it too
+    if (current_char == '(' && next_char_lookup(read_buffer) == '*') {
+        next_char(read_buffer);
+        skip_block_comment(read_buffer, 1, SIZE_MAX);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Skips whitespace and comments.
+ * 
+ * @param read_buffer Read buffer.
+ * @return First char of the next token (already read), or EOF.
+ */
+char skip_to_token(ReadBuffer* read_buffer) {
+    while (1) {
+        skip_whitespace(read_buffer);
+
+        char current_char = next_char(read_buffer);
+
+        // Ignore whitespace and comments
+        if (current_char != EOF && (iswhitespace(current_char) || remove_comments(read_buffer)))
+            continue;
+
+        return current_char;
+    }
+}
+
+/**
+ * @brief Reads the token that starts with current_char.
+ * A lexical error gives a TOKEN_ERROR token, whose text is the offending input.
+ * 
+ * @param read_buffer Read buffer, positioned just after current_char.
+ * @param current_char First char of the token, as returned by skip_to_token.
+ * @param arena Receives the texts that can't point into the input.
+ * @param text Receives the text of identifiers, types, integers, strings (without quotes) and errors, not null terminated.
+ * Only set for tokens with text.
+ * @param token Receives the token.
+ * @param diagnostics Receives the error, if any. May be NULL. Running out of memory sets its failed flag.
+ * @return Size of the text, 0 for tokens without text.
+ */
+size_t lex_token(ReadBuffer* read_buffer, char current_char, Arena* arena, const char** text, Token* token, DiagnosticList* diagnostics) {
+    size_t token_start = read_buffer->block_offset + read_buffer->current_position - 1;
+    token->line = buffer_line(read_buffer);
+    token->as.symbol = TOKEN_NO_SYMBOL;
+
+    size_t text_size = 0;
+
+    // Strings
+    if (CHAR_IS(current_char, CHAR_CLASS_STRING_START)) {
+        int status = extract_string(read_buffer, arena, text, &text_size, diagnostics);
+        token->kind = status == LEXER_OK ? TOKEN_STRING : TOKEN_ERROR;
+    }
+    // Not a string and not a name, might be a terminal
+    else if (!isname(current_char)) {
+        token->kind = extract_terminal(read_buffer);
+
+        if (token->kind == TOKEN_NONE) {
+            add_diagnostic(diagnostics, read_buffer, LEXER_ERROR_INVALID_CHARACTER, NULL,
+                           "invalid character %c",
+                           current_char);
+
+            token->kind = TOKEN_ERROR;
+            *text = source_text(read_buffer, arena, read_buffer->current_position - 1);
+            text_size = 1;
+        }
+    }
+    // None of the above, handle everything else (keywords, identifiers, type identifiers, integers)
+    else {
+        text_size = extract_general_name(read_buffer, arena, text);
+        const char* name = *text;
+
+        // Out of memory, reported below
+        if (name == NULL)
+            token->kind = TOKEN_ERROR;
+        // Integers
+        else if (CHAR_IS(name[0], CHAR_CLASS_DIGIT)) {
+            token->kind = TOKEN_INTEGER;
+
+            if (!parse_integer(name, text_size, &token->as.value)) {
+                add_diagnostic(diagnostics, read_buffer, LEXER_ERROR_WRONG_INTEGER32_FORMAT, NULL,
+                               "%.*s is not a positive 32-bit signed integer (max value allowed %d)",
+                               (int)text_size,
+                               name,
+                               INT32_MAX);
+
+                token->kind = TOKEN_ERROR;
+            }
+        } else {
+            // Check keywords
+            token->kind = check_keyword(name, text_size);
+
+            // Test for true and false special case
+            if ((token->kind == TOKEN_TRUE || token->kind == TOKEN_FALSE) && name[0] >= 'A' && name[0] <= 'Z') {
+                add_diagnostic(diagnostics, read_buffer, LEXER_ERROR_UPPERCASE_BOOLEAN_KEYWORD, NULL,
+                               "keyword %s may not start with a capital letter",
+                               token_kind_names[token->kind]);
+
+                token->kind = TOKEN_ERROR;
+            }
+
+            // Check Type, otherwise it's an identifier
+            if (token->kind == TOKEN_IDENTIFIER && name[0] >= 'A' && name[0] <= 'Z')
+                token->kind = TOKEN_TYPE;
+        }
+    }
+
+    // The text couldn't be kept, so lexing stops here
+    if (TOKEN_HAS_TEXT(token->kind) && *text == NULL) {
+        report_out_of_memory(diagnostics, read_buffer);
+        token->kind = TOKEN_ERROR;
+        *text = "";
+        text_size = 0;
+    }
+
+    token->offset = token_start;
+    token->length = read_buffer->block_offset + read_buffer->current_position - token_start;
+
+    return TOKEN_HAS_TEXT(token->kind) ? text_size : 0;
+}
+
+/**
+ * @brief Makes token the TOKEN_EOF token at the current position.
+ * 
+ * @param read_buffer Read buffer.
+ * @param token Receives the token.
+ */
+static void end_token(ReadBuffer* read_buffer, Token* token) {
+    token->kind = TOKEN_EOF;
+    token->offset = read_buffer->block_offset + read_buffer->current_position;
+    token->length = 0;
+    token->line = buffer_line(read_buffer);
+    token->as.symbol = TOKEN_NO_SYMBOL;
+}
+
+/**
+ * @brief Reads the next token, skipping whitespace and comments.
+ * 
+ * @param read_buffer Read buffer.
+ * @param arena Receives the texts that can't point into the input.
+ * @param text Receives the text of identifiers, types, integers, strings (without quotes) and errors, not null terminated.
+ * Only set for tokens with text.
+ * @param token Receives the token, its kind is TOKEN_EOF at the end of file.
+ * @param diagnostics Receives the lexical errors. May be NULL.
+ * @param stats Receives the time spent skipping and reading the token, when built with LEXER_STATS.
+ * NULL if this token isn't timed.
+ * @return Size of the text, 0 for tokens without text.
+ */
+size_t next_token(ReadBuffer* read_buffer, Arena* arena, const char** text, Token* token, DiagnosticList* diagnostics,
+                  LexerStats* stats) {
+    STATS_START(stats, ticks);
+    char current_char = skip_to_token(read_buffer);
+    STATS_LAP(stats, skip_ticks, ticks);
+
+    if (current_char == EOF) {
+        end_token(read_buffer, token);
+        return 0;
+    }
+
+    size_t text_size = lex_token(read_buffer, current_char, arena, text, token, diagnostics);
+    STATS_LAP(stats, token_ticks, ticks);
+
+    return text_size;
+}
+
+#ifdef LEXER_STATS
+uint64_t stats_tick_cost;
+
+/**
+ * @brief Measures stats_tick_cost: the smallest difference between two back to back stats_ticks calls.
+ * 
+ */
+void stats_calibrate(void) {
+    uint64_t cost = UINT64_MAX;
+
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start = stats_ticks();
+        uint64_t lap = stats_ticks() - start;
+
+        if (lap < cost)
+            cost = lap;
+    }
+
+    stats_tick_cost = cost;
+}
+
+static pthread_once_t stats_calibrated = PTHREAD_ONCE_INIT;
+#endif
+
+/**
+ * @brief Allocates a zeroed lexer with a private copy of name, opening the source is left to the caller.
+ * 
+ * @param name Name of the source.
+ * @return New lexer or NULL if out of memory.
+ */
+static Lexer* lexer_alloc(const char* name) {
+#ifdef LEXER_STATS
+    pthread_once(&stats_calibrated, stats_calibrate);
+#endif
+
+    Lexer* lexer = calloc(1, sizeof(Lexer));
+
+    if (lexer == NULL)
+        return NULL;
+
+    lexer->name = malloc(strlen(name) + 1);
+
+    if (lexer->name == NULL) {
+        free(lexer);
+        return NULL;
+    }
+
+    strcpy(lexer->name, name);
+    return lexer;
+}
+
+Lexer* lexer_open_file(const char* filename) {
+    Lexer* lexer = lexer_alloc(filename);
+
+    if (lexer == NULL)
+        return NULL;
+
+    lexer->fp = fopen(filename, "rb");
+
+    if (lexer->fp == NULL) {
+        lexer_close(lexer);
+        return NULL;
+    }
+
+    init_buffer(&lexer->read_buffer, lexer->fp, lexer->name);
+    return lexer;
+}
+
+Lexer* lexer_open_memory(const char* data, size_t size, const char* name) {
+    Lexer* lexer = lexer_alloc(name);
+
+    if (lexer == NULL)
+        return NULL;
+
+    if (!init_buffer_memory(&lexer->read_buffer, data, size, lexer->name)) {
+        lexer_close(lexer);
+        return NULL;
+    }
+
+    return lexer;
+}
+
+int lexer_next_token(Lexer* lexer, Token* token) {
+    lexer->text = "";
+    lexer->text_size = 0;
+
+    LexerStats* timed = STATS_SAMPLE(&lexer->stats, lexer->stats_sample);
+
+    if (!lexer->diagnostics.failed)
+        lexer->text_size = next_token(&lexer->read_buffer, &lexer->arena, &lexer->text, token, &lexer->diagnostics,
+                                      timed);
+
+    // Out of memory, the source ends here for the caller
+    if (lexer->diagnostics.failed) {
+        lexer->text = "";
+        lexer->text_size = 0;
+        end_token(&lexer->read_buffer, token);
+        return 0;
+    }
+
+    STATS_COUNT(lexer->stats.tokens[token->kind]);
+
+    if (TOKEN_HAS_SYMBOL(token->kind)) {
+        STATS_START(timed, ticks);
+        token->as.symbol = symbol_intern(&lexer->symbols, &lexer->arena, lexer->text, lexer->text_size,
+                                      symbol_hash(lexer->text, lexer->text_size));
+        STATS_LAP(timed, symbol_ticks, ticks);
+
+        // Out of memory, the name has no id so the source ends here, as with the arena
+        if (token->as.symbol == TOKEN_NO_SYMBOL) {
+            report_out_of_memory(&lexer->diagnostics, &lexer->read_buffer);
+            lexer->text = "";
+            lexer->text_size = 0;
+            end_token(&lexer->read_buffer, token);
+            return 0;
+        }
+    }
+
+    return token->kind != TOKEN_EOF;
+}
+
+const char* lexer_token_text(const Lexer* lexer, size_t* size) {
+    if (size != NULL)
+        *size = lexer->text_size;
+
+    return lexer->text;
+}
+
+uint32_t lexer_symbol_count(const Lexer* lexer) {
+    return lexer->symbols.count;
+}
+
+const char* lexer_symbol_text(const Lexer* lexer, uint32_t symbol, size_t* size) {
+    if (size != NULL)
+        *size = lexer->symbols.symbols[symbol].size;
+
+    return lexer->symbols.symbols[symbol].text;
+}
+
+int lexer_stats(const Lexer* lexer, LexerStats* stats) {
+#ifdef LEXER_STATS
+    *stats = lexer->stats;
+    stats->bytes = lexer->read_buffer.block_offset + lexer->read_buffer.total_size;
+    stats->refills = lexer->read_buffer.refills;
+    return 1;
+#else
+    (void)lexer;
+    *stats = (LexerStats){0};
+    return 0;
+#endif
+}
+
+const LexerDiagnostic* lexer_diagnostics(const Lexer* lexer, size_t* count) {
+    *count = lexer->diagnostics.count;
+    return lexer->diagnostics.items;
+}
+
+int lexer_report_diagnostics(const Lexer* lexer) {
+    // One block, so the reports of files lexed on other threads don't get mixed in
+    flockfile(stdout);
+
+    for (size_t i = 0; i < lexer->diagnostics.count; i++) {
+        const LexerDiagnostic* diagnostic = &lexer->diagnostics.items[i];
+
+        printf("%s:%zu: \33[31mERROR:\33[0m ", lexer->name, diagnostic->line);
+        fwrite(diagnostic->message, 1, diagnostic->message_size, stdout);
+        printf("\n");
+
+        if (diagnostic->hint != NULL)
+            printf("\33[36mHINT:\33[0m %s\n", diagnostic->hint);
+    }
+
+    funlockfile(stdout);
+
+    return lexer->diagnostics.status;
+}
+
+void lexer_close(Lexer* lexer) {
+    if (lexer == NULL)
+        return;
+
+    // Also safe when the source was never opened, the buffer is zeroed
+    free_buffer(&lexer->read_buffer);
+
+    if (lexer->fp != NULL)
+        fclose(lexer->fp);
+
+    free_diagnostics(&lexer->diagnostics);
+    symbol_table_free(&lexer->symbols);
+    arena_free(&lexer->arena);
+    free(lexer->name);
+    free(lexer);
+}
@@ -1,519 +1,441 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include <ctype.h>
 #include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 
-// Constants
-#define INPUT_FILE_BLOCK_SIZE       4096
-#define LITERAL_STRING_MAX_SIZE     1024
-#define GENERAL_NAME_MAX_SIZE       1024       
-
-// Return codes codes
-#define LEXER_OK                                0
-#define LEXER_ERROR_INCORRECT_USAGE             1
-#define LEXER_ERROR_FILE_IO                     2
-#define LEXER_ERROR_IDENTIFIER_NAME_TOO_LONG    3
-#define LEXER_ERROR_STRING_LITERAL_TOO_LONG     4
-#define LEXER_ERROR_WRONG_INTEGER32_FORMAT      5
-#define LEXER_ERROR_UPPERCASE_BOOLEAN_KEYWORD   6
-#define LEXER_ERROR_INVALID_CHARACTER           7
-#define LEXER_ERROR_INVALID_STRING_CHARACTER    8
-#define LEXER_ERROR_NON_ESCAPED_NEWLINE         9
-
-// Size of a static C-style array. Don't use on pointers!
-#define ARRAYSIZE(_ARR)             ((int)(sizeof(_ARR) / sizeof(*(_ARR))))
+#include "binary.h"
+#include "lexer.h"
+#include "output.h"
+#include "pool.h"
+#include "stats.h"
+#include "token.h"
+
+// Output formats
+#define OUTPUT_FORMAT_TEXT          0
+#define OUTPUT_FORMAT_BINARY        1
 
 /**
- * @brief ReadBuffer struct.
- * Automatically manages rebuffering, line counting and lookaheads.
+ * @brief Options struct.
+ * Everything given in the command line. All file names are owned copies.
  * 
  */
-typedef struct ReadBuffer {
-    FILE* fp;
-    const char* filename;
-    uint8_t content[INPUT_FILE_BLOCK_SIZE];
-
-    size_t current_position;
-    size_t total_size;
-    size_t current_line;
-} ReadBuffer;
+typedef struct Options {
+    int output_format;
+    int stats;
+    int jobs;
+    size_t split_size;
+    char** files;
+    size_t file_count;
+    size_t file_capacity;
+} Options;
 
 /**
- * @brief Initializes the Read Buffer with the first 4096 bytes from in_file.
+ * @brief Appends a copy of filename to the files to lex.
  * 
- * @param in_file File to read.
- * @return ReadBuffer with file contents.
+ * @return 1 on success, 0 if out of memory.
  */
-ReadBuffer init_buffer(FILE* in_file, const char* in_filename) {
-    ReadBuffer buf = {.fp = in_file, .filename = in_filename, .current_position = 0, .current_line = 1};
+int add_file(Options* options, const char* filename) {
+    if (options->file_count == options->file_capacity) {
+        size_t capacity = options->file_capacity == 0 ? 16 : options->file_capacity * 2;
+        char** files = realloc(options->files, capacity * sizeof(char*));
 
-    buf.total_size = fread(buf.content, 1, INPUT_FILE_BLOCK_SIZE, buf.fp);
-    return buf;
-}
+        if (files == NULL)
+            return 0;
 
-/**
- * @brief Returns the next char in the buffer AND advances the internal position tracker.
- * If there aren't any more chars in the buffer, the file is automatically read again to refill the buffer.
- * 
- * @param buf Read buffer.
- * @return Next char in the buffer, if the end of file is reached, returns EOF.
- */
-char next_char(ReadBuffer* buf) {
-    if (buf->current_position == buf->total_size) {
-        buf->total_size = fread(buf->content, 1, INPUT_FILE_BLOCK_SIZE, buf->fp);
-        buf->current_position = 0;
-
-        // End of file
-        if (buf->total_size == 0)
-            return EOF;
+        options->files = files;
+        options->file_capacity = capacity;
     }
 
-    if (buf->content[buf->current_position] == '\n')
-        buf->current_line++;
+    char* copy = malloc(strlen(filename) + 1);
 
-    return buf->content[buf->current_position++];
+    if (copy == NULL)
+        return 0;
+
+    strcpy(copy, filename);
+    options->files[options->file_count++] = copy;
+    return 1;
 }
 
 /**
- * @brief Returns the next character in the buffer. DOES NOT advance the internal position tracker.
- * Therefore, this function can be used to look ahead one character.
- * If there aren't any more chars in the buffer, the file is automatically read again to refill the buffer.
+ * @brief Adds every line of list_filename (one file name per line, empty lines are skipped) to the files to lex.
  * 
- * @param buf Read buffer.
- * @return Next char in the buffer, if the end of file is reached, returns EOF.
+ * @return 1 on success, 0 if the list couldn't be read.
  */
-char next_char_lookup(ReadBuffer* buf) {
-    if (buf->current_position == buf->total_size) {
-        fpos_t old_pos;
-        fgetpos(buf->fp, &old_pos);
+int add_files_from(Options* options, const char* list_filename) {
+    FILE* fp = fopen(list_filename, "r");
 
-        char next_char = fgetc(buf->fp);
+    if (fp == NULL)
+        return 0;
 
-        if (next_char == EOF)
-            return EOF;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_size;
+    int ok = 1;
 
-        fsetpos(buf->fp, &old_pos);
+    while (ok && (line_size = getline(&line, &line_capacity, fp)) != -1) {
+        while (line_size > 0 && (line[line_size - 1] == '\n' || line[line_size - 1] == '\r'))
+            line[--line_size] = '\0';
 
-        return next_char;
+        if (line_size > 0)
+            ok = add_file(options, line);
     }
 
-    return buf->content[buf->current_position];
+    free(line);
+    fclose(fp);
+    return ok;
 }
 
-/**
- * @brief Returns the current character in the buffer. DOES NOT advance the internal position tracker.
- * Therefore, this function can be used to lookup the current character.
- * If there aren't any characters available, returns EOF.
- * 
- * @param buf Read buffer.
- * @return Current char in the buffer or EOF as stated above.
- */
-char current_char_lookup(ReadBuffer* buf) {
-    if (buf->current_position == 0)
-        return EOF;
+void free_options(Options* options) {
+    for (size_t i = 0; i < options->file_count; i++)
+        free(options->files[i]);
 
-    return buf->content[buf->current_position - 1];
+    free(options->files);
 }
 
-int iswhitespace(char c) {
-    if (c == ' ' || c == '\n' || c == '\f' || c == '\r' || c == '\t' || c == '\v')
-        return 1;
+/**
+ * @brief Parses the command line: [--format=text|binary] [-j jobs] [--split[=bytes]] [--files-from list] [--stats] [files...].
+ * 
+ * @param argc Argument count.
+ * @param argv Arguments.
+ * @param options Receives the options, with defaults for the ones not given.
+ * @return 1 on success, 0 on incorrect usage.
+ */
+int parse_options(int argc, char* argv[], Options* options) {
+    *options = (Options){.output_format = OUTPUT_FORMAT_TEXT, .jobs = 1};
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = NULL;
+
+        if (strcmp(argv[i], "--format=text") == 0) {
+            options->output_format = OUTPUT_FORMAT_TEXT;
+        } else if (strcmp(argv[i], "--format=binary") == 0) {
+            options->output_format = OUTPUT_FORMAT_BINARY;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->stats = 1;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            // -j N or -jN
+            value = argv[i][2] != '\0' ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+
+            char* end;
+            long jobs = value != NULL ? strtol(value, &end, 10) : 0;
+
+            if (value == NULL || *end != '\0' || jobs < 1 || jobs > 1024)
+                return 0;
+
+            options->jobs = jobs;
+        } else if (strncmp(argv[i], "--split", 7) == 0) {
+            // --split or --split=bytes
+            char* end = argv[i] + 7;
+            unsigned long long split_size = LEXER_DEFAULT_CHUNK_SIZE;
+
+            if (*end == '=')
+                split_size = strtoull(argv[i] + 8, &end, 10);
+
+            if (*end != '\0' || split_size == 0)
+                return 0;
+
+            options->split_size = split_size;
+        } else if (strncmp(argv[i], "--files-from", 12) == 0) {
+            // --files-from list or --files-from=list
+            if (argv[i][12] == '=')
+                value = argv[i] + 13;
+            else if (argv[i][12] == '\0' && i + 1 < argc)
+                value = argv[++i];
+            else
+                return 0;
+
+            if (!add_files_from(options, value)) {
+                printf("\33[31mERROR:\33[0m could not read file list %s\n", value);
+                return 0;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return 0;
+        } else if (!add_file(options, argv[i])) {
+            return 0;
+        }
+    }
 
-    return 0;
+    return options->file_count > 0;
 }
 
-int isname(char c) {
-    if (isalnum(c) || c == '_')
-        return 1;
-
-    return 0;
+/**
+ * @brief TokenWriter struct.
+ * Where write_token sends the tokens of one file. output_ticks is the time spent writing them (LEXER_STATS only),
+ * measured on the tokens picked by stats_sample (see STATS_SAMPLE).
+ * 
+ */
+typedef struct TokenWriter {
+    OutputBuffer* out;
+    int output_format;
+    BinaryWriter binary;
+    uint64_t output_ticks;
+    uint32_t stats_sample;
+} TokenWriter;
+
+void write_token(void* context, const Token* token, const char* text, size_t text_size) {
+    TokenWriter* writer = context;
+    TokenWriter* timed = STATS_SAMPLE(writer, writer->stats_sample);
+    STATS_START(timed, ticks);
+
+    // Only the binary format marks its end
+    if (writer->output_format == OUTPUT_FORMAT_BINARY)
+        write_token_binary(&writer->binary, token, text, text_size);
+    else if (token->kind != TOKEN_EOF)
+        write_token_text(writer->out, token, text, text_size);
+
+    STATS_LAP(timed, output_ticks, ticks);
 }
 
-void extract_general_name(ReadBuffer* read_buffer, char* name_buffer) {
-    // Get char that triggered this function call
-    name_buffer[0] = current_char_lookup(read_buffer);
-
-    size_t current_buffer_pos = 1;
-
-    while (1) {
-        if (!isname(next_char_lookup(read_buffer)))
-            break;
-
-        if (current_buffer_pos == GENERAL_NAME_MAX_SIZE) {
-            printf("%s:%lld: \33[31mERROR:\33[0m identifier or keyword name too long (max %d chars allowed)\n",
-                   read_buffer->filename,
-                   read_buffer->current_line,
-                   GENERAL_NAME_MAX_SIZE);
-
-            exit(LEXER_ERROR_IDENTIFIER_NAME_TOO_LONG);
-        }
-        
-        name_buffer[current_buffer_pos++] = next_char(read_buffer);
-    }
-
-    // Mark end
-    name_buffer[current_buffer_pos] = '\0';
+#ifdef LEXER_STATS
+static void print_phase(const char* name, uint64_t ticks, uint64_t total_ticks, double ticks_per_ms) {
+    printf("    %-28s %10.2f ms %6.1f%%\n", name, ticks / ticks_per_ms, total_ticks > 0 ? 100.0 * ticks / total_ticks : 0);
 }
 
-void extract_string(ReadBuffer* read_buffer, char* name_buffer) {
-    size_t current_buffer_pos = 0;
+/**
+ * @brief Prints the statistics of one file as a single block, so the ones of files lexed on other threads don't get mixed in.
+ * Ticks are turned into milliseconds with the tick rate measured over the whole file.
+ * 
+ * @param filename Name of the source file.
+ * @param stats Statistics of the lexer.
+ * @param output_ticks Time spent writing the tokens and closing the output.
+ * @param total_ticks Time from opening the source to closing the output.
+ * @param seconds Same time, in seconds.
+ */
+static void print_stats(const char* filename, const LexerStats* stats, uint64_t output_ticks, uint64_t total_ticks,
+                        double seconds) {
+    double ticks_per_ms = seconds > 0 ? total_ticks / (seconds * 1000) : 1;
+    uint64_t lexing_ticks = stats->skip_ticks + stats->token_ticks + stats->symbol_ticks;
+    size_t tokens = 0;
+    struct rusage usage;
 
-    while (1) {
-        if (current_buffer_pos == LITERAL_STRING_MAX_SIZE) {
-            printf("%s:%lld: \33[31mERROR:\33[0m literal string too long (max %d chars allowed)\n",
-                   read_buffer->filename,
-                   read_buffer->current_line,
-                   LITERAL_STRING_MAX_SIZE);
+    for (int kind = 0; kind < TOKEN_KIND_COUNT; kind++)
+        if (kind != TOKEN_EOF)
+            tokens += stats->tokens[kind];
 
-            exit(LEXER_ERROR_STRING_LITERAL_TOO_LONG);
-        }
+    flockfile(stdout);
 
-        char previous_char = current_char_lookup(read_buffer);
-        char current_char = next_char(read_buffer);
+    printf("%s: %zu bytes, %zu refills, %zu tokens in %.2f ms (%.1f MB/s)\n", filename, stats->bytes, stats->refills,
+           tokens, seconds * 1000, seconds > 0 ? stats->bytes / seconds / 1e6 : 0);
 
-        // Check end of string (also works for empty strings)
-        // TODO: Fix bug when string is "anything\\"
-        if (previous_char != '\\' && current_char == '\"')
-            break;
+    print_phase("skipping whitespace/comments", stats->skip_ticks, total_ticks, ticks_per_ms);
+    print_phase("reading tokens", stats->token_ticks, total_ticks, ticks_per_ms);
+    print_phase("interning names", stats->symbol_ticks, total_ticks, ticks_per_ms);
+    print_phase("writing output", output_ticks, total_ticks, ticks_per_ms);
 
-        // Check invalid
-        if (current_char == '\0' || current_char == EOF) {
-            printf("%s:%lld: \33[31mERROR:\33[0m literal string may not contain null character or EOF\n",
-                   read_buffer->filename,
-                   read_buffer->current_line);
+    // Opening, mapping, diagnostics and the split bookkeeping. Thread times can add up to more than the whole
+    if (lexing_ticks + output_ticks <= total_ticks)
+        print_phase("other", total_ticks - lexing_ticks - output_ticks, total_ticks, ticks_per_ms);
 
-            exit(LEXER_ERROR_INVALID_STRING_CHARACTER);
-        }
+    for (int kind = 0; kind < TOKEN_KIND_COUNT; kind++)
+        if (kind != TOKEN_EOF && stats->tokens[kind] > 0)
+            printf("    %-28s %10zu\n", token_kind_names[kind], stats->tokens[kind]);
 
-        // Multiline string
-        if (next_char_lookup(read_buffer) == '\n') {
-            if (current_char == '\\') {
-                // Consume end of line
-                next_char(read_buffer);
-                continue;
-            } else {
-                // Incorrect multiline
-                printf("%s:%lld: \33[31mERROR:\33[0m non-escaped newline character inside literal string.\n"
-                       "\33[36mHINT:\33[0m add \\ before newline or close this string with \"\n",
-                       read_buffer->filename,
-                       read_buffer->current_line);
-
-                exit(LEXER_ERROR_NON_ESCAPED_NEWLINE);
-            }
-        }
-
-        // Valid char
-        name_buffer[current_buffer_pos++] = current_char;
-    }
+    // Of the whole process so far, ru_maxrss is in KiB
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        printf("    %-28s %10.1f MiB\n", "peak memory", usage.ru_maxrss / 1024.0);
 
-    // Mark end
-    name_buffer[current_buffer_pos] = '\0';
+    funlockfile(stdout);
 }
+#endif
 
-const char* extract_terminal(ReadBuffer* read_buffer) {
-    // Get char that triggered this function call
-    switch (current_char_lookup(read_buffer)) {
-    case '(':
-        return "lparen";
-        break;
-
-    case ')':
-        return "rparen";
-        break;
-
-    case '*':
-        return "times";
-        break;
-
-    case '+':
-        return "plus";
-        break;
-
-    case ',':
-        return "comma";
-        break;
-
-    case '-':
-        return "minus";
-        break;
-
-    case '.':
-        return "dot";
-        break;
-
-    case '/':
-        return "divide";
-        break;
-
-    case ':':
-        return "colon";
-        break;
-
-    case ';':
-        return "semi";
-        break;
-
-    case '<':
-        switch (next_char_lookup(read_buffer)) {
-        case '-':
-            next_char(read_buffer);
-            return "larrow";
-            break;
-        
-        case '=':
-            next_char(read_buffer);
-            return "le";
-            break;
-
-        default:
-            return "lt";
-            break;
-        }
-        break;
-
-    case '=':
-        switch (next_char_lookup(read_buffer)) {
-        case '>':
-            next_char(read_buffer);
-            return "rarrow";
-            break;
-
-        default:
-            return "equals";
-            break;
-        }
-        break;
-
-    case '@':
-        return "at";
-        break;
-
-    case '{':
-        return "lbrace";
-        break;
+/**
+ * @brief Lexes the whole file and writes its tokens to filename-lex (text) or filename-lexbin (binary).
+ * With options->split_size set, the file is split in chunks of that size lexed on options->jobs threads.
+ * Lexical errors don't stop the lexer, they are all printed once the whole file is lexed.
+ * With options->stats set, the statistics of the file are printed after its errors.
+ * 
+ * @param options Command line options.
+ * @param filename Name of the source file.
+ * @return LEXER_OK, LEXER_ERROR_FILE_IO if a file couldn't be opened or written,
+ * or the code of the first lexical error (the errors are printed).
+ */
+int lex_file(const Options* options, const char* filename) {
+#ifdef LEXER_STATS
+    struct timespec start_time, end_time;
 
-    case '}':
-        return "rbrace";
-        break;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    uint64_t start_ticks = stats_ticks();
+#endif
 
-    case '~':
-        return "tilde";
-        break;
-    }
+    Lexer* source = lexer_open_file(filename);
 
-    return NULL;
-}
-
-const char* check_keyword(char* text) {
-    static const char* keywords[] = {"class", "else", "false", "fi", "if", 
-                                     "in", "inherits", "isvoid", "let", "loop", 
-                                     "pool", "then", "while", "case", "esac", 
-                                     "new", "of", "not", "true"};
-
-    // Convert to lowercase for case insensitive keywords 
-    size_t text_size = strlen(text) + 1;
-    char text_lower[text_size]; // This needs C99
-
-    for (size_t i = 0; i < text_size; i++)
-        text_lower[i] = tolower(text[i]);
-    
-    // Try to find keyword
-    for (int i = 0; i < ARRAYSIZE(keywords); i++) {
-        if (strcmp(text_lower, keywords[i]) == 0) {
-            return keywords[i];
-        }
+    if (source == NULL) {
+        printf("\33[31mERROR:\33[0m could not open file %s\n", filename);
+        return LEXER_ERROR_FILE_IO;
     }
 
-    return NULL;
-}
-
-int check_integer(char* text) {
-    size_t text_size = strlen(text);
-
-    // Check 1: no longer than 10 chars
-    if (text_size > 10)
-        return 0;
+    // Output file
+    const char* suffix = options->output_format == OUTPUT_FORMAT_BINARY ? "-lexbin" : "-lex";
+    char out_filename[strlen(filename) + strlen(suffix) + 1];
 
-    // Check 2: only digits
-    for (size_t i = 0; i < text_size; i++)
-        if (!isdigit(text[i]))
-            return 0;
+    strcpy(out_filename, filename);
+    strcat(out_filename, suffix);
 
-    // Check 3: if text size is 10, first digit cannot be bigger than 2
-    if (text_size == 10 && text[0] > '2')
-        return 0;
-        
-    // Now we can safely convert the number
-    // It can always fit under a UINT32 since its max value is 2999999999
-    uint32_t num = 0;
+    OutputBuffer* out = output_open(out_filename);
 
-    for (int32_t i = text_size - 1, power = 1; i >= 0; i--, power *= 10)
-        num += (text[i] - 48) * power;
+    if (out == NULL) {
+        printf("\33[31mERROR:\33[0m could not open output file %s\n", out_filename);
+        lexer_close(source);
+        return LEXER_ERROR_FILE_IO;
+    }
 
-    // Check 4: no bigger than INT32_MAX
-    return num <= INT32_MAX;
-}
+    TokenWriter writer = {.out = out, .output_format = options->output_format};
 
-int remove_comments(ReadBuffer* read_buffer) {
-    // Get current char again (we are not inside the main while loop)
-    char current_char = current_char_lookup(read_buffer);
+    if (options->output_format == OUTPUT_FORMAT_BINARY)
+        binary_writer_init(&writer.binary, out);
 
-    // Handling one line comments
-    if (current_char == '-' && next_char_lookup(read_buffer) == '-') {
-        do {
-            current_char = next_char(read_buffer);
-        } while (current_char != '\n' && current_char != EOF);
+    if (options->split_size != 0) {
+        lexer_lex_parallel(source, options->jobs, options->split_size, write_token, &writer);
+    } else {
+        Token token;
 
-        return 1;
-    }
+        while (lexer_next_token(source, &token)) {
+            size_t text_size;
+            const char* text = lexer_token_text(source, &text_size);
 
-    // Handling multiple line comments
-    if (current_char == '(' && next_char_lookup(read_buffer) == '*') {
-        while (current_char != EOF) {
-            if (current_char == '*' && next_char_lookup(read_buffer) == ')')
-                break;
-            
-            current_char = next_char(read_buffer);
+            write_token(&writer, &token, text, text_size);
         }
 
-        // Now, next_char is ')' or EOF, so it must be removed (for EOF nothing happens)
-        next_char(read_buffer);
-
-        return 1;
+        write_token(&writer, &token, NULL, 0);
     }
 
-    return 0;
-}
+    int status = lexer_report_diagnostics(source);
 
-void lexer(FILE* fp, const char* filename) {
-    // Output file
-    char out_filename[strlen(filename) + 5];
+#ifdef LEXER_STATS
+    LexerStats stats;
+    lexer_stats(source, &stats);
+#endif
 
-    strcpy(out_filename, filename);
-    strcat(out_filename, "-lex");
+    lexer_close(source);
 
-    FILE* fp_lex = fopen(out_filename, "wb");
+    STATS_START(&writer, close_ticks);
+    int closed = output_close(out);
+    STATS_LAP_ONCE(&writer, output_ticks, close_ticks);
 
-    if (fp_lex == NULL) {
-        printf("\33[31mERROR:\33[0m could not open output file %s\n", out_filename);
-        exit(LEXER_ERROR_FILE_IO);
+    if (!closed) {
+        printf("\33[31mERROR:\33[0m could not write output file %s\n", out_filename);
+        return LEXER_ERROR_FILE_IO;
     }
 
-    // Buffer data
-    ReadBuffer read_buffer = init_buffer(fp, filename);
-    static char name_buffer[LITERAL_STRING_MAX_SIZE + 1];
-    
-    while (1) {
-        char current_char = next_char(&read_buffer);
+#ifdef LEXER_STATS
+    uint64_t total_ticks = stats_ticks() - start_ticks;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
 
-        if (current_char == EOF)
-            break;
+    if (options->stats)
+        print_stats(filename, &stats, writer.output_ticks, total_ticks,
+                    (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9);
+#endif
 
-        // Ignore whitespace and comments
-        if (iswhitespace(current_char))
-            continue;
+    return status;
+}
 
-        if (remove_comments(&read_buffer))
-            continue;
+/**
+ * @brief Batch struct.
+ * Shared by the workers lexing several files, each task is one file.
+ * 
+ */
+typedef struct Batch {
+    const Options* options;
+    int* statuses;
+} Batch;
 
-        // Now we can find something
-        fprintf(fp_lex, "%lld\n", read_buffer.current_line);
+void lex_file_task(void* context, size_t task, int worker) {
+    Batch* batch = context;
+    (void)worker;
 
-        // Strings
-        if (current_char == '\"') {
-            extract_string(&read_buffer, name_buffer);
+    batch->statuses[task] = lex_file(batch->options, batch->options->files[task]);
+}
 
-            fprintf(fp_lex, "string\n%s\n", name_buffer);
-            continue;
-        }
+typedef struct FileSize {
+    size_t index;
+    off_t size;
+} FileSize;
 
-        // Not a string and not a name, might be a terminal
-        if (!isname(current_char)) {
-            const char* terminal_name = extract_terminal(&read_buffer);
+int compare_file_size_descending(const void* a, const void* b) {
+    off_t size_a = ((const FileSize*)a)->size;
+    off_t size_b = ((const FileSize*)b)->size;
 
-            if (terminal_name == NULL) {
-                printf("%s:%lld: \33[31mERROR:\33[0m invalid character %c\n",
-                    read_buffer.filename,
-                    read_buffer.current_line,
-                    current_char);
+    return (size_a < size_b) - (size_a > size_b);
+}
 
-                exit(LEXER_ERROR_INVALID_CHARACTER);
-            }
+/**
+ * @brief Lexes every file given in the options, on options->jobs threads, largest files first.
+ * When the files are split, they are lexed one after the other and the threads are used inside each file.
+ * 
+ * @param options Command line options.
+ * @return LEXER_OK if every file was lexed, otherwise the error of the first file (in command line order) that failed.
+ */
+int lex_files(const Options* options) {
+    size_t count = options->file_count;
 
-            fprintf(fp_lex, "%s\n", terminal_name);
-            continue;
-        }
+    FileSize* sizes = malloc(count * sizeof(FileSize));
+    size_t* order = malloc(count * sizeof(size_t));
+    int* statuses = malloc(count * sizeof(int));
 
-        // None of the above, handle everything else (keywords, identifiers, type identifiers, integers)
-        extract_general_name(&read_buffer, name_buffer);
+    if (sizes == NULL || order == NULL || statuses == NULL) {
+        free(sizes);
+        free(order);
+        free(statuses);
+        return LEXER_ERROR_FILE_IO;
+    }
 
-        // Integers
-        if (isdigit(name_buffer[0])) {
-            if (check_integer(name_buffer) == 1) {
-                fprintf(fp_lex, "integer\n%s\n", name_buffer);
-                continue;
-            }
+    // Start the biggest files first so no big file is left running alone at the end
+    for (size_t i = 0; i < count; i++) {
+        struct stat file_stat;
 
-            printf("%s:%lld: \33[31mERROR:\33[0m %s is not a positive 32-bit signed integer (max value allowed %d)\n",
-                    read_buffer.filename,
-                    read_buffer.current_line,
-                    name_buffer,
-                    INT32_MAX);
+        sizes[i].index = i;
+        sizes[i].size = stat(options->files[i], &file_stat) == 0 ? file_stat.st_size : 0;
+        statuses[i] = LEXER_OK;
+    }
 
-            exit(LEXER_ERROR_WRONG_INTEGER32_FORMAT);
-        }
+    qsort(sizes, count, sizeof(FileSize), compare_file_size_descending);
 
-        // Check keywords
-        const char* keyword = check_keyword(name_buffer);
+    for (size_t i = 0; i < count; i++)
+        order[i] = sizes[i].index;
 
-        if (keyword != NULL) {
-            // Test for true and false special case
-            if (strcmp(keyword, "true") || strcmp(keyword, "false")) {
-                if (name_buffer[0] >= 'A' && name_buffer[0] <= 'Z') {
-                    printf("%s:%lld: \33[31mERROR:\33[0m keyword %s may not start with a capital letter\n",
-                        read_buffer.filename,
-                        read_buffer.current_line,
-                        keyword);
+    Batch batch = {.options = options, .statuses = statuses};
 
-                    exit(LEXER_ERROR_UPPERCASE_BOOLEAN_KEYWORD);
-                }
-            }
+    // Fall back to this thread if no threads could be created
+    if (options->split_size != 0)
+        pool_run(1, count, order, lex_file_task, &batch);
+    else if (!pool_run(options->jobs, count, order, lex_file_task, &batch))
+        pool_run(1, count, order, lex_file_task, &batch);
 
-            fprintf(fp_lex, "%s\n", keyword);
-            continue;
-        }   
-        
-        // Check Type
-        if (name_buffer[0] >= 'A' && name_buffer[0] <= 'Z') {
-            fprintf(fp_lex, "type\n%s\n", name_buffer);
-            continue;
-        }
+    int status = LEXER_OK;
 
-        // Last case: identifier
-        fprintf(fp_lex, "identifier\n%s\n", name_buffer);
-    }
+    for (size_t i = 0; i < count && status == LEXER_OK; i++)
+        status = statuses[i];
 
-    fclose(fp_lex);
+    free(sizes);
+    free(order);
+    free(statuses);
+    return status;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        printf("\33[31mERROR:\33[0m expected usage: %s [file]\n", argv[0]);
+    Options options;
+
+    if (!parse_options(argc, argv, &options)) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [--format=text|binary] [-j jobs] [--split[=bytes]] [--files-from list] [--stats] [files...]\n", argv[0]);
+        free_options(&options);
         return LEXER_ERROR_INCORRECT_USAGE;
     }
 
-    FILE* fp = fopen(argv[1], "rb");
-
-    if (fp == NULL) {
-        printf("\33[31mERROR:\33[0m could not open file %s\n", argv[1]);
-        return LEXER_ERROR_FILE_IO;
+#ifndef LEXER_STATS
+    if (options.stats) {
+        printf("\33[31mERROR:\33[0m --stats needs a lexer built with statistics: make STATS=YES\n");
+        free_options(&options);
+        return LEXER_ERROR_INCORRECT_USAGE;
     }
+#endif
 
     // Start lexical analysis
-    lexer(fp, argv[1]);
+    int status = lex_files(&options);
 
-    fclose(fp);
+    free_options(&options);
 
-    return LEXER_OK;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "output.h"
+
+/**
+ * @brief Writes all size bytes to fd, retrying partial and interrupted writes.
+ * 
+ * @return 1 on success, 0 on error.
+ */
+static int write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return 0;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Creates (or truncates) filename and attaches an empty buffer to it.
+ * 
+ * @param filename File to write.
+ * @return New output buffer, or NULL if the file couldn't be opened.
+ */
+OutputBuffer* output_open(const char* filename) {
+    OutputBuffer* out = malloc(sizeof(OutputBuffer));
+
+    if (out == NULL)
+        return NULL;
+
+    out->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (out->fd < 0) {
+        free(out);
+        return NULL;
+    }
+
+    out->failed = 0;
+    out->used = 0;
+    return out;
+}
+
+/**
+ * @brief Writes everything in the buffer to the file and empties it.
+ * 
+ * @param out Output buffer.
+ */
+void output_flush(OutputBuffer* out) {
+    if (out->used > 0 && !write_all(out->fd, out->data, out->used))
+        out->failed = 1;
+
+    out->used = 0;
+}
+
+/**
+ * @brief Slow path of output_write, for data that doesn't fit in the free space.
+ * Data bigger than the whole buffer skips it and goes straight to the file.
+ * 
+ * @param out Output buffer.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ */
+void output_write_slow(OutputBuffer* out, const void* data, size_t size) {
+    output_flush(out);
+
+    if (size >= OUTPUT_BUFFER_SIZE) {
+        if (!write_all(out->fd, data, size))
+            out->failed = 1;
+
+        return;
+    }
+
+    memcpy(out->data, data, size);
+    out->used = size;
+}
+
+/**
+ * @brief Flushes the buffer, closes the file and frees the buffer.
+ * 
+ * @param out Output buffer.
+ * @return 1 if everything was written, 0 if any write failed.
+ */
+int output_close(OutputBuffer* out) {
+    output_flush(out);
+
+    int ok = !out->failed && close(out->fd) == 0;
+
+    free(out);
+    return ok;
+}
+
+/**
+ * @brief Formats value in decimal, two digits at a time. dest needs room for OUTPUT_MAX_NUMBER_SIZE chars.
+ * 
+ * @param dest Where the digits are written (not null terminated).
+ * @param value Number to format.
+ * @return Pointer past the last digit.
+ */
+static char* output_format_u32(char* dest, uint32_t value) {
+    static const char digit_pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    char digits[OUTPUT_MAX_NUMBER_SIZE];
+    char* start = digits + OUTPUT_MAX_NUMBER_SIZE;
+
+    // Fill from the end
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+
+        *--start = digit_pairs[pair + 1];
+        *--start = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        *--start = digit_pairs[value * 2 + 1];
+        *--start = digit_pairs[value * 2];
+    } else {
+        *--start = '0' + value;
+    }
+
+    size_t size = digits + OUTPUT_MAX_NUMBER_SIZE - start;
+    memcpy(dest, start, size);
+
+    return dest + size;
+}
+
+/**
+ * @brief Writes a token in the .cl-lex text format: line, kind name and text (only for tokens with text).
+ * 
+ * @param out Output buffer.
+ * @param token Token to write.
+ * @param text Text of the token, ignored for keywords and terminals.
+ * @param text_size Size of text.
+ */
+void write_token_text(OutputBuffer* out, const Token* token, const char* text, size_t text_size) {
+    size_t name_size = token_kind_name_sizes[token->kind];
+
+    // Line and kind name always fit together in the buffer
+    char* dest = output_reserve(out, OUTPUT_MAX_NUMBER_SIZE + name_size + 2);
+
+    dest = output_format_u32(dest, token->line);
+    *dest++ = '\n';
+
+    memcpy(dest, token_kind_names[token->kind], name_size);
+    dest += name_size;
+    *dest++ = '\n';
+
+    out->used = dest - out->data;
+
+    if (TOKEN_HAS_TEXT(token->kind)) {
+        output_write(out, text, text_size);
+        output_write(out, "\n", 1);
+    }
+}
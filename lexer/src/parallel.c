@@ -0,0 +1,516 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "lexer.h"
+#include "lexer_internal.h"
+#include "pool.h"
+#include "read_buffer.h"
+#include "symbol.h"
+#include "scan.h"
+#include "stats.h"
+#include "token.h"
+
+// States a chunk may begin (and end) in. Chunks begin at line starts, so a -- comment can't be open there.
+// A (* *) comment state also has a depth, the number of nested comments open
+#define CHUNK_STATE_NORMAL      0
+#define CHUNK_STATE_STRING      1
+#define CHUNK_STATE_COMMENT     2
+#define CHUNK_STATE_COUNT       3
+
+// Exit state of a chunk where the source ends: an EOF char (0xFF bytes are read as EOF too)
+#define CHUNK_STATE_END         3
+
+// Chunks are lexed a window at a time, and each window is handed out and freed before the next one is lexed.
+// A window gives every worker about CHUNK_WINDOW_BYTES of source, in 1 to CHUNK_WINDOW_MAX_CHUNKS chunks
+#define CHUNK_WINDOW_BYTES      (1024 * 1024)
+#define CHUNK_WINDOW_MAX_CHUNKS 256
+
+/**
+ * @brief ChunkToken struct.
+ * Token found by a chunk run, its text is in the input or in the run's arena.
+ * The symbol of identifiers and types is an id in the run's own symbol table.
+ * 
+ */
+typedef struct ChunkToken {
+    Token token;
+    const char* text;
+    size_t text_size;
+} ChunkToken;
+
+/**
+ * @brief ChunkRun struct.
+ * Result of lexing one chunk under one entry state. Lines (of tokens and diagnostics) are relative to the start of the chunk.
+ * exit_state is the state the lexer is in at the end of the chunk: a string or comment that goes on
+ * past the end belongs to this run, the next chunk only skips its rest.
+ * entry_depth and exit_depth are the comment depths that go with the entry and exit states.
+ * global_symbols maps the ids of the run's symbol table to the ids of the lexer's one, it's filled while stitching.
+ * stats holds the phase times of the run (LEXER_STATS only), added to the lexer's ones while stitching.
+ * stats_sample picks the tokens it times (see STATS_SAMPLE).
+ * 
+ */
+typedef struct ChunkRun {
+    int done;
+    int exit_state;
+    int out_of_memory;
+    size_t entry_depth;
+    size_t exit_depth;
+
+    ChunkToken* tokens;
+    size_t token_count;
+    size_t token_capacity;
+
+    Arena arena;
+    SymbolTable symbols;
+    uint32_t* global_symbols;
+
+    size_t eof_offset;
+    size_t eof_line;
+
+    DiagnosticList diagnostics;
+    LexerStats stats;
+    uint32_t stats_sample;
+} ChunkRun;
+
+/**
+ * @brief ChunkJob struct.
+ * Shared by the workers, each task is one (chunk, entry state) pair of the current window. Comment states are tried
+ * with depth 1, the only one seen in practice at a line start: a deeper one is lexed again while stitching.
+ * Chunk i spans [starts[i], starts[i + 1]). The window is the window_count chunks from first_chunk on,
+ * newlines and runs only cover it: chunk first_chunk + i holds newlines[i] newlines.
+ * 
+ */
+typedef struct ChunkJob {
+    const ReadBuffer* source;
+    size_t chunk_count;
+    size_t* starts;
+    size_t first_chunk;
+    size_t window_count;
+    size_t* newlines;
+    ChunkRun* runs;
+} ChunkJob;
+
+/**
+ * @brief Appends a token to the run, its text is already in the run's arena.
+ * 
+ * @return 1 on success, 0 if out of memory.
+ */
+static int append_token(ChunkRun* run, const Token* token, const char* text, size_t text_size) {
+    if (run->token_count == run->token_capacity) {
+        size_t capacity = run->token_capacity == 0 ? 1024 : run->token_capacity * 2;
+        ChunkToken* tokens = realloc(run->tokens, capacity * sizeof(ChunkToken));
+
+        if (tokens == NULL)
+            return 0;
+
+        run->tokens = tokens;
+        run->token_capacity = capacity;
+    }
+
+    run->tokens[run->token_count++] = (ChunkToken){.token = *token, .text = text, .text_size = text_size};
+    return 1;
+}
+
+/**
+ * @brief Finds the state at end, when only whitespace and comments are left between from and the next token.
+ * 
+ * @param read_buffer Read buffer, its position is moved.
+ * @param from Position after the last token.
+ * @param end End of the chunk.
+ * @param depth Receives the comment depth at end.
+ * @return CHUNK_STATE_COMMENT if a (* *) comment is open at end, CHUNK_STATE_NORMAL otherwise.
+ */
+static int boundary_state(ReadBuffer* read_buffer, size_t from, size_t end, size_t* depth) {
+    read_buffer->current_position = from;
+
+    while (1) {
+        skip_whitespace(read_buffer);
+
+        if (read_buffer->current_position >= end)
+            return CHUNK_STATE_NORMAL;
+
+        char current_char = next_char(read_buffer);
+
+        if (current_char == EOF)
+            return CHUNK_STATE_NORMAL;
+
+        if (iswhitespace(current_char))
+            continue;
+
+        // Same as remove_comments, but (* *) comments stop at end to get their depth there
+        if (current_char == '(' && next_char_lookup(read_buffer) == '*') {
+            next_char(read_buffer);
+            *depth = skip_block_comment(read_buffer, 1, end);
+
+            if (*depth > 0 && read_buffer->current_position >= end)
+                return CHUNK_STATE_COMMENT;
+
+            continue;
+        }
+
+        // A -- comment always stops at the newline before end
+        if (!remove_comments(read_buffer))
+            return CHUNK_STATE_NORMAL;
+    }
+}
+
+/**
+ * @brief Lexes the tokens that begin in [current position, end) under the given entry state.
+ * 
+ * @return Exit state of the chunk.
+ */
+static int lex_chunk_tokens(ReadBuffer* read_buffer, int entry_state, size_t end, ChunkRun* run) {
+    const char* text = "";
+    size_t text_size;
+
+    // Finish the string or comment the chunk begins in, it belongs to a previous chunk
+    if (entry_state == CHUNK_STATE_STRING) {
+        if (extract_string(read_buffer, &run->arena, &text, &text_size, NULL) == LEXER_ERROR_OUT_OF_MEMORY) {
+            run->out_of_memory = 1;
+            return CHUNK_STATE_END;
+        }
+
+        if (read_buffer->current_position > end)
+            return CHUNK_STATE_STRING;
+    } else if (entry_state == CHUNK_STATE_COMMENT) {
+        run->exit_depth = skip_block_comment(read_buffer, run->entry_depth, end);
+
+        // Still open at the end of the chunk, unless the source ends there (then the EOF is found below)
+        if (run->exit_depth > 0 && read_buffer->current_position >= end && end < read_buffer->total_size)
+            return CHUNK_STATE_COMMENT;
+    }
+
+    while (1) {
+        size_t from = read_buffer->current_position;
+        LexerStats* timed = STATS_SAMPLE(&run->stats, run->stats_sample);
+
+        STATS_START(timed, ticks);
+        char current_char = skip_to_token(read_buffer);
+        STATS_LAP(timed, skip_ticks, ticks);
+
+        // The serial lexer stops at the first EOF char
+        if (current_char == EOF && read_buffer->current_position <= end) {
+            run->eof_offset = read_buffer->current_position;
+            run->eof_line = buffer_line(read_buffer);
+            return CHUNK_STATE_END;
+        }
+
+        // The next token belongs to the next chunk
+        if (current_char == EOF || read_buffer->current_position - 1 >= end)
+            return boundary_state(read_buffer, from, end, &run->exit_depth);
+
+        Token token;
+
+        text = "";
+        text_size = lex_token(read_buffer, current_char, &run->arena, &text, &token, &run->diagnostics);
+        STATS_LAP(timed, token_ticks, ticks);
+
+        if (run->diagnostics.failed) {
+            run->out_of_memory = 1;
+            return CHUNK_STATE_END;
+        }
+
+        // The names stay in the input or the run's arena, both outlive the table
+        if (TOKEN_HAS_SYMBOL(token.kind)) {
+            token.as.symbol = symbol_intern(&run->symbols, NULL, text, text_size, symbol_hash(text, text_size));
+            STATS_LAP(timed, symbol_ticks, ticks);
+        }
+
+        if (run->symbols.failed || !append_token(run, &token, text, text_size)) {
+            run->out_of_memory = 1;
+            return CHUNK_STATE_END;
+        }
+
+        // Only strings (valid or not) may go on past the end of the chunk
+        if (read_buffer->current_position > end)
+            return CHUNK_STATE_STRING;
+    }
+}
+
+/**
+ * @brief Lexes one chunk under one entry state.
+ * 
+ * @param job Chunk job.
+ * @param chunk Index of the chunk.
+ * @param entry_state State the chunk is assumed to begin in.
+ * @param entry_depth Comment depth that goes with entry_state.
+ */
+static void lex_chunk(ChunkJob* job, size_t chunk, int entry_state, size_t entry_depth) {
+    ChunkRun* run = &job->runs[(chunk - job->first_chunk) * CHUNK_STATE_COUNT + entry_state];
+    ReadBuffer read_buffer;
+
+    init_buffer_view(&read_buffer, job->source, job->starts[chunk]);
+    run->entry_depth = entry_depth;
+
+    run->exit_state = lex_chunk_tokens(&read_buffer, entry_state, job->starts[chunk + 1], run);
+    run->done = 1;
+}
+
+/**
+ * @brief Tells if chunk may begin in entry_state. The first chunk begins in the normal state, and a chunk can
+ * only begin inside a string if the newline before it is escaped.
+ * 
+ */
+static int entry_state_possible(const ChunkJob* job, size_t chunk, int entry_state) {
+    size_t start = job->starts[chunk];
+
+    if (chunk == 0)
+        return entry_state == CHUNK_STATE_NORMAL;
+
+    if (entry_state == CHUNK_STATE_STRING)
+        return start >= 2 && job->source->data[start - 2] == '\\';
+
+    return 1;
+}
+
+static void lex_chunk_task(void* context, size_t task, int worker) {
+    ChunkJob* job = context;
+    size_t chunk = job->first_chunk + task / CHUNK_STATE_COUNT;
+    int entry_state = task % CHUNK_STATE_COUNT;
+    (void)worker;
+
+    if (entry_state == CHUNK_STATE_NORMAL) {
+        size_t start = job->starts[chunk];
+        job->newlines[task / CHUNK_STATE_COUNT] = scan_newlines(job->source->data + start, job->starts[chunk + 1] - start);
+    }
+
+    if (entry_state_possible(job, chunk, entry_state))
+        lex_chunk(job, chunk, entry_state, entry_state == CHUNK_STATE_COMMENT);
+}
+
+/**
+ * @brief Splits the source into chunks of about chunk_size bytes, each one beginning just after a newline,
+ * and allocates a window of window_count chunks.
+ * 
+ * @return 1 on success, 0 if out of memory.
+ */
+static int split_chunks(ChunkJob* job, size_t chunk_size, size_t window_count) {
+    const uint8_t* data = job->source->data;
+    size_t size = job->source->total_size;
+    size_t capacity = size / chunk_size + 2;
+
+    job->starts = malloc(capacity * sizeof(size_t));
+
+    if (job->starts == NULL)
+        return 0;
+
+    job->starts[0] = 0;
+    job->chunk_count = 1;
+
+    while (job->starts[job->chunk_count - 1] + chunk_size < size) {
+        size_t position = job->starts[job->chunk_count - 1] + chunk_size;
+        const uint8_t* newline = memchr(data + position, '\n', size - position);
+
+        if (newline == NULL || (size_t)(newline - data) + 1 >= size)
+            break;
+
+        job->starts[job->chunk_count++] = newline - data + 1;
+    }
+
+    job->starts[job->chunk_count] = size;
+
+    job->window_count = window_count < job->chunk_count ? window_count : job->chunk_count;
+    job->newlines = calloc(job->window_count, sizeof(size_t));
+    job->runs = calloc(job->window_count * CHUNK_STATE_COUNT, sizeof(ChunkRun));
+    return job->newlines != NULL && job->runs != NULL;
+}
+
+/**
+ * @brief Frees what the run found and makes it not done again.
+ * 
+ */
+static void reset_chunk_run(ChunkRun* run) {
+    free(run->tokens);
+    arena_free(&run->arena);
+    symbol_table_free(&run->symbols);
+    free(run->global_symbols);
+    free_diagnostics(&run->diagnostics);
+
+    *run = (ChunkRun){0};
+}
+
+/**
+ * @brief Frees the runs of the current window, ready for the next one.
+ * 
+ */
+static void reset_window(ChunkJob* job) {
+    if (job->runs != NULL) {
+        for (size_t i = 0; i < job->window_count * CHUNK_STATE_COUNT; i++)
+            reset_chunk_run(&job->runs[i]);
+    }
+}
+
+static void free_chunk_job(ChunkJob* job) {
+    reset_window(job);
+
+    free(job->starts);
+    free(job->newlines);
+    free(job->runs);
+}
+
+/**
+ * @brief Lexes the rest of the source with lexer_next_token and hands the tokens to callback.
+ * 
+ */
+static void lex_serial(Lexer* lexer, LexerTokenCallback callback, void* context) {
+    Token token;
+
+    while (lexer_next_token(lexer, &token)) {
+        size_t text_size;
+        const char* text = lexer_token_text(lexer, &text_size);
+
+        callback(context, &token, text, text_size);
+    }
+
+    callback(context, &token, "", 0);
+}
+
+/**
+ * @brief Hands the tokens of the run chosen for a chunk to callback, with their lines and symbols made global.
+ * Nothing is handed out if the run ran out of memory or if its symbols can't be interned, so the chunk can be
+ * lexed again from its start.
+ * 
+ * @param lines_before Newlines before the chunk.
+ * @return 1 on success, 0 if out of memory.
+ */
+static int emit_chunk_run(Lexer* lexer, ChunkRun* run, size_t lines_before, LexerTokenCallback callback, void* context) {
+    // A run without names needs no map (and malloc(0) may return NULL)
+    if (run->symbols.count > 0)
+        run->global_symbols = malloc(run->symbols.count * sizeof(uint32_t));
+
+    if (run->out_of_memory || (run->symbols.count > 0 && run->global_symbols == NULL))
+        return 0;
+
+    // Symbols are numbered by first appearance in each run, so interning them in that order keeps the serial ids.
+    // If this fails halfway, the names already interned are the first new ones the serial lexer meets, in the same order
+    for (uint32_t id = 0; id < run->symbols.count; id++) {
+        const Symbol* symbol = &run->symbols.symbols[id];
+        run->global_symbols[id] = symbol_intern(&lexer->symbols, &lexer->arena, symbol->text, symbol->size, symbol->hash);
+
+        if (run->global_symbols[id] == TOKEN_NO_SYMBOL)
+            return 0;
+    }
+
+    for (size_t i = 0; i < run->token_count; i++) {
+        Token token = run->tokens[i].token;
+        token.line += lines_before;
+
+        if (TOKEN_HAS_SYMBOL(token.kind))
+            token.as.symbol = run->global_symbols[token.as.symbol];
+
+        STATS_COUNT(lexer->stats.tokens[token.kind]);
+        callback(context, &token, run->tokens[i].text, run->tokens[i].text_size);
+    }
+
+    move_diagnostics(&lexer->diagnostics, &run->diagnostics, lines_before);
+
+#ifdef LEXER_STATS
+    lexer->stats.skip_ticks += run->stats.skip_ticks;
+    lexer->stats.token_ticks += run->stats.token_ticks;
+    lexer->stats.symbol_ticks += run->stats.symbol_ticks;
+#endif
+
+    return 1;
+}
+
+/**
+ * @brief Finishes the source after memory ran out at chunk, once the chunks before it were handed out.
+ * A chunk that begins in the normal state is lexed serially from its start to the end of the source.
+ * Inside a string or comment that isn't possible, so the source ends there with an out of memory diagnostic.
+ * 
+ * @param state State the chunk begins in.
+ */
+static void finish_serial(Lexer* lexer, const ChunkJob* job, size_t chunk, int state, LexerTokenCallback callback,
+                          void* context) {
+    ReadBuffer* source = &lexer->read_buffer;
+    source->current_position = job->starts[chunk];
+
+    if (state == CHUNK_STATE_NORMAL) {
+        lex_serial(lexer, callback, context);
+        return;
+    }
+
+    report_out_of_memory(&lexer->diagnostics, source);
+
+    Token eof_token = {.offset = source->current_position, .length = 0, .line = buffer_line(source),
+                       .as.symbol = TOKEN_NO_SYMBOL, .kind = TOKEN_EOF};
+
+    STATS_COUNT(lexer->stats.tokens[TOKEN_EOF]);
+    callback(context, &eof_token, "", 0);
+}
+
+int lexer_lex_parallel(Lexer* lexer, int jobs, size_t chunk_size, LexerTokenCallback callback, void* context) {
+    ReadBuffer* source = &lexer->read_buffer;
+    ChunkJob job = {.source = source};
+    size_t worker_chunks = chunk_size > 0 ? CHUNK_WINDOW_BYTES / chunk_size : 0;
+
+    if (worker_chunks < 1)
+        worker_chunks = 1;
+    else if (worker_chunks > CHUNK_WINDOW_MAX_CHUNKS)
+        worker_chunks = CHUNK_WINDOW_MAX_CHUNKS;
+
+    // On one thread the speculative runs are only extra work
+    if (jobs <= 1 || !buffer_is_whole(source) || source->current_position != 0 || chunk_size == 0 ||
+        !split_chunks(&job, chunk_size, (size_t)jobs * worker_chunks) || job.chunk_count == 1) {
+        free_chunk_job(&job);
+        lex_serial(lexer, callback, context);
+        return 0;
+    }
+
+    size_t window_count = job.window_count;
+    Token eof_token = {.offset = source->total_size, .length = 0, .line = 1, .as.symbol = TOKEN_NO_SYMBOL, .kind = TOKEN_EOF};
+    size_t lines_before = 0;
+    int state = CHUNK_STATE_NORMAL;
+    size_t depth = 0;
+
+    // Follow the chain of runs from the first chunk, each entry state is the exit state of the run before.
+    // Only the window being lexed is kept, so memory doesn't grow with the size of the source
+    for (job.first_chunk = 0; job.first_chunk < job.chunk_count && state < CHUNK_STATE_COUNT; job.first_chunk += window_count) {
+        if (job.chunk_count - job.first_chunk < window_count)
+            job.window_count = job.chunk_count - job.first_chunk;
+
+        size_t task_count = job.window_count * CHUNK_STATE_COUNT;
+
+        // Fall back to this thread if no threads could be created
+        if (!pool_run(jobs, task_count, NULL, lex_chunk_task, &job))
+            pool_run(1, task_count, NULL, lex_chunk_task, &job);
+
+        for (size_t i = 0; i < job.window_count && state < CHUNK_STATE_COUNT; i++) {
+            size_t chunk = job.first_chunk + i;
+            ChunkRun* run = &job.runs[i * CHUNK_STATE_COUNT + state];
+
+            // A comment nested deeper than the speculative run assumed
+            if (run->done && run->entry_depth != depth)
+                reset_chunk_run(run);
+
+            // Also happens for states that were ruled out, kept as a safety net
+            if (!run->done)
+                lex_chunk(&job, chunk, state, depth);
+
+            if (!emit_chunk_run(lexer, run, lines_before, callback, context)) {
+                finish_serial(lexer, &job, chunk, state, callback, context);
+                free_chunk_job(&job);
+                return chunk > 0;
+            }
+
+            if (run->exit_state == CHUNK_STATE_END) {
+                eof_token.offset = run->eof_offset;
+                eof_token.line = run->eof_line + lines_before;
+            }
+
+            lines_before += job.newlines[i];
+            state = run->exit_state;
+            depth = state == CHUNK_STATE_COMMENT ? run->exit_depth : 0;
+        }
+
+        reset_window(&job);
+    }
+
+    STATS_COUNT(lexer->stats.tokens[TOKEN_EOF]);
+    callback(context, &eof_token, "", 0);
+
+    free_chunk_job(&job);
+    return 1;
+}
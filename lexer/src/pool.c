@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+/**
+ * @brief PoolQueue struct.
+ * Tasks dealt to one worker. The owner takes from head, thieves take from tail.
+ * 
+ */
+typedef struct PoolQueue {
+    pthread_mutex_t lock;
+    size_t* tasks;
+    size_t head;
+    size_t tail;
+} PoolQueue;
+
+typedef struct Pool {
+    PoolQueue* queues;
+    int worker_count;
+    PoolTask task;
+    void* context;
+} Pool;
+
+typedef struct PoolWorker {
+    Pool* pool;
+    int index;
+} PoolWorker;
+
+/**
+ * @brief Takes the next task from the front (own queue) or the back (stolen) of a queue.
+ * 
+ * @return 1 if a task was taken, 0 if the queue is empty.
+ */
+static int pool_take(PoolQueue* queue, int steal, size_t* task) {
+    int taken = 0;
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->head < queue->tail) {
+        *task = steal ? queue->tasks[--queue->tail] : queue->tasks[queue->head++];
+        taken = 1;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return taken;
+}
+
+static void* pool_worker(void* argument) {
+    PoolWorker* worker = argument;
+    Pool* pool = worker->pool;
+    size_t task;
+
+    while (1) {
+        if (pool_take(&pool->queues[worker->index], 0, &task)) {
+            pool->task(pool->context, task, worker->index);
+            continue;
+        }
+
+        // Own queue is empty, tasks are never added back, so one failed pass over the others means we're done
+        int stolen = 0;
+
+        for (int i = 1; i < pool->worker_count && !stolen; i++) {
+            int victim = (worker->index + i) % pool->worker_count;
+
+            if (pool_take(&pool->queues[victim], 1, &task)) {
+                pool->task(pool->context, task, worker->index);
+                stolen = 1;
+            }
+        }
+
+        if (!stolen)
+            return NULL;
+    }
+}
+
+int pool_run(int worker_count, size_t task_count, const size_t* order, PoolTask task, void* context) {
+    if (worker_count < 1)
+        worker_count = 1;
+
+    if ((size_t)worker_count > task_count)
+        worker_count = task_count > 0 ? task_count : 1;
+
+    // Nothing to share, run everything in order here
+    if (worker_count == 1) {
+        for (size_t i = 0; i < task_count; i++)
+            task(context, order != NULL ? order[i] : i, 0);
+
+        return 1;
+    }
+
+    Pool pool = {.worker_count = worker_count, .task = task, .context = context};
+
+    pool.queues = calloc(worker_count, sizeof(PoolQueue));
+    size_t* tasks = malloc(task_count * sizeof(size_t));
+    PoolWorker* workers = malloc(worker_count * sizeof(PoolWorker));
+    pthread_t* threads = malloc(worker_count * sizeof(pthread_t));
+
+    int ok = pool.queues != NULL && tasks != NULL && workers != NULL && threads != NULL;
+
+    if (ok) {
+        // Deal round robin: queue w gets tasks w, w + worker_count, ... stored contiguously
+        size_t next = 0;
+
+        for (int w = 0; w < worker_count; w++) {
+            pthread_mutex_init(&pool.queues[w].lock, NULL);
+            pool.queues[w].tasks = tasks + next;
+            pool.queues[w].head = 0;
+            pool.queues[w].tail = 0;
+
+            for (size_t i = w; i < task_count; i += worker_count)
+                pool.queues[w].tasks[pool.queues[w].tail++] = order != NULL ? order[i] : i;
+
+            next += pool.queues[w].tail;
+        }
+
+        int started = 0;
+
+        for (; started < worker_count; started++) {
+            workers[started] = (PoolWorker){.pool = &pool, .index = started};
+
+            if (pthread_create(&threads[started], NULL, pool_worker, &workers[started]) != 0)
+                break;
+        }
+
+        // Workers that did start finish everything, stealing from the queues of the missing ones
+        for (int w = 0; w < started; w++)
+            pthread_join(threads[w], NULL);
+
+        ok = started > 0;
+
+        for (int w = 0; w < worker_count; w++)
+            pthread_mutex_destroy(&pool.queues[w].lock);
+    }
+
+    free(pool.queues);
+    free(tasks);
+    free(workers);
+    free(threads);
+    return ok;
+}
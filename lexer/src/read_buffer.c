@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "read_buffer.h"
+#include "scan.h"
+#include "stats.h"
+
+/**
+ * @brief Tries to memory map the whole in_file. Only regular, non empty files can be mapped.
+ * The file is mapped over a slightly bigger anonymous mapping, so there is always room for the sentinel padding,
+ * even when the file size is a multiple of the page size.
+ * 
+ * @param buf Read buffer to initialize.
+ * @return 1 if the file was mapped, 0 otherwise.
+ */
+static int map_buffer(ReadBuffer* buf) {
+    struct stat file_stat;
+
+    if (fstat(fileno(buf->fp), &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0)
+        return 0;
+
+    size_t file_size = file_stat.st_size;
+    size_t mapped_size = file_size + READ_BUFFER_PADDING;
+
+    uint8_t* region = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (region == MAP_FAILED)
+        return 0;
+
+    if (mmap(region, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fileno(buf->fp), 0) == MAP_FAILED) {
+        munmap(region, mapped_size);
+        return 0;
+    }
+
+    // The lexer reads the file front to back only once
+    madvise(region, file_size, MADV_SEQUENTIAL);
+
+    // Private mapping, the file itself is never written
+    memset(region + file_size, READ_BUFFER_SENTINEL, READ_BUFFER_PADDING);
+
+    buf->data = region;
+    buf->total_size = file_size;
+    buf->mapped_size = mapped_size;
+    buf->reached_eof = 1;
+    return 1;
+}
+
+/**
+ * @brief Returns the line of the last char returned by next_char.
+ * The newlines read since the previous call are counted in bulk with SIMD, so lines only cost
+ * something when they are needed (when a token is emitted or an error is reported).
+ * 
+ * @param buf Read buffer.
+ * @return Current line.
+ */
+size_t buffer_line(ReadBuffer* buf) {
+    buf->current_line += scan_newlines(buf->data + buf->line_position, buf->current_position - buf->line_position);
+    buf->line_position = buf->current_position;
+
+    return buf->current_line;
+}
+
+/**
+ * @brief Reads the next block from the file. The char before the current position and all the unread ones
+ * are moved to the front of content first, so current_char_lookup keeps working.
+ * 
+ * @param buf Read buffer (buffered mode only).
+ */
+static void refill_buffer(ReadBuffer* buf) {
+    size_t keep_start = buf->current_position > 0 ? buf->current_position - 1 : 0;
+    size_t keep_size = buf->total_size - keep_start;
+
+    // Count the lines of everything read so far, it's about to be discarded
+    buffer_line(buf);
+
+    memmove(buf->content, buf->content + keep_start, keep_size);
+    buf->block_offset += keep_start;
+    buf->current_position -= keep_start;
+    buf->line_position -= keep_start;
+
+    // fread only returns less than requested at end of file (or on errors)
+    size_t read_size = fread(buf->content + keep_size, 1, INPUT_FILE_BLOCK_SIZE, buf->fp);
+    STATS_COUNT(buf->refills);
+
+    buf->total_size = keep_size + read_size;
+    buf->reached_eof = read_size < INPUT_FILE_BLOCK_SIZE;
+
+    memset(buf->content + buf->total_size, READ_BUFFER_SENTINEL, READ_BUFFER_PADDING);
+}
+
+/**
+ * @brief Initializes the Read Buffer with the whole mapped in_file, or with its first 4096 bytes if it can't be mapped.
+ * 
+ * @param buf Read buffer to initialize.
+ * @param in_file File to read.
+ * @param in_filename Name of the file, used for error messages.
+ */
+void init_buffer(ReadBuffer* buf, FILE* in_file, const char* in_filename) {
+    buf->fp = in_file;
+    buf->filename = in_filename;
+    buf->block_offset = 0;
+    buf->current_position = 0;
+    buf->current_line = 1;
+    buf->line_position = 0;
+    buf->mapped_size = 0;
+    buf->allocated = NULL;
+    buf->refills = 0;
+
+    if (map_buffer(buf))
+        return;
+
+    buf->data = buf->content;
+    buf->total_size = 0;
+    refill_buffer(buf);
+}
+
+/**
+ * @brief Initializes the Read Buffer with a copy of in_data, followed by the sentinel padding.
+ * 
+ * @param buf Read buffer to initialize.
+ * @param in_data Source text, doesn't need to be null terminated.
+ * @param in_size Size of in_data.
+ * @param in_name Name of the source, used for error messages.
+ * @return 1 on success, 0 if the copy couldn't be allocated.
+ */
+int init_buffer_memory(ReadBuffer* buf, const char* in_data, size_t in_size, const char* in_name) {
+    buf->allocated = malloc(in_size + READ_BUFFER_PADDING);
+
+    if (buf->allocated == NULL)
+        return 0;
+
+    memcpy(buf->allocated, in_data, in_size);
+    memset(buf->allocated + in_size, READ_BUFFER_SENTINEL, READ_BUFFER_PADDING);
+
+    buf->fp = NULL;
+    buf->filename = in_name;
+    buf->data = buf->allocated;
+    buf->block_offset = 0;
+    buf->current_position = 0;
+    buf->total_size = in_size;
+    buf->current_line = 1;
+    buf->line_position = 0;
+    buf->mapped_size = 0;
+    buf->reached_eof = 1;
+    buf->refills = 0;
+    return 1;
+}
+
+/**
+ * @brief Tells if the whole input is in data: mapped files, memory inputs and files that fit in the first block.
+ * 
+ * @param buf Read buffer.
+ * @return 1 if data holds the whole input, 0 if there are more blocks to read.
+ */
+int buffer_is_whole(const ReadBuffer* buf) {
+    return buf->reached_eof && buf->block_offset == 0;
+}
+
+/**
+ * @brief Initializes buf as a read only view of the whole input held by source, starting at the given position.
+ * Lines are counted from the start of the view, which is line 1. The view doesn't own anything,
+ * so free_buffer does nothing and it must not outlive source.
+ * 
+ * @param buf Read buffer to initialize.
+ * @param source Read buffer holding the whole input (see buffer_is_whole).
+ * @param start Position where reading starts.
+ */
+void init_buffer_view(ReadBuffer* buf, const ReadBuffer* source, size_t start) {
+    buf->fp = NULL;
+    buf->filename = source->filename;
+    buf->data = source->data;
+    buf->block_offset = 0;
+    buf->current_position = start;
+    buf->total_size = source->total_size;
+    buf->current_line = 1;
+    buf->line_position = start;
+    buf->mapped_size = 0;
+    buf->allocated = NULL;
+    buf->reached_eof = 1;
+    buf->refills = 0;
+}
+
+/**
+ * @brief Releases the file mapping or the memory copy, if there is one.
+ * 
+ * @param buf Read buffer.
+ */
+void free_buffer(ReadBuffer* buf) {
+    if (buf->mapped_size != 0)
+        munmap((void*)buf->data, buf->mapped_size);
+
+    free(buf->allocated);
+
+    buf->mapped_size = 0;
+    buf->allocated = NULL;
+}
+
+/**
+ * @brief Slow path, taken when a sentinel byte is found at the current position.
+ * The sentinel is either a real char from the file, the end of the current block (the buffer is refilled) or the end of file.
+ * 
+ * @param buf Read buffer.
+ * @return 1 if there is a char at the current position, 0 if the end of file was reached.
+ */
+int check_sentinel(ReadBuffer* buf) {
+    if (buf->current_position < buf->total_size)
+        return 1;
+
+    if (buf->reached_eof)
+        return 0;
+
+    refill_buffer(buf);
+
+    return buf->current_position < buf->total_size;
+}
@@ -0,0 +1,314 @@
+#include <stdatomic.h>
+
+#include "charclass.h"
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+typedef size_t (*ScanWhitespaceFn)(const uint8_t* text);
+typedef size_t (*ScanNewlinesFn)(const uint8_t* text, size_t length);
+typedef size_t (*ScanStringFn)(const uint8_t* text);
+typedef size_t (*ScanUntilFn)(const uint8_t* text, uint8_t first_stop, uint8_t second_stop);
+
+static size_t scan_whitespace_resolve(const uint8_t* text);
+static size_t scan_newlines_resolve(const uint8_t* text, size_t length);
+static size_t scan_string_resolve(const uint8_t* text);
+static size_t scan_until_resolve(const uint8_t* text, uint8_t first_stop, uint8_t second_stop);
+
+// Start pointing to the resolvers, which pick the best implementations on the first call.
+// Atomic because several lexers may race on the first call, relaxed loads are plain loads anyway
+static _Atomic(ScanWhitespaceFn) scan_whitespace_impl = scan_whitespace_resolve;
+static _Atomic(ScanNewlinesFn) scan_newlines_impl = scan_newlines_resolve;
+static _Atomic(ScanStringFn) scan_string_impl = scan_string_resolve;
+static _Atomic(ScanUntilFn) scan_until_impl = scan_until_resolve;
+
+#define SCAN_LOAD(_IMPL)            atomic_load_explicit(&(_IMPL), memory_order_relaxed)
+#define SCAN_STORE(_IMPL, _FN)      atomic_store_explicit(&(_IMPL), (_FN), memory_order_relaxed)
+
+static size_t scan_whitespace_scalar(const uint8_t* text) {
+    size_t length = 0;
+
+    while (CHAR_IS(text[length], CHAR_CLASS_WHITESPACE))
+        length++;
+
+    return length;
+}
+
+static size_t scan_newlines_scalar(const uint8_t* text, size_t length) {
+    size_t newlines = 0;
+
+    for (size_t i = 0; i < length; i++)
+        newlines += text[i] == '\n';
+
+    return newlines;
+}
+
+static size_t scan_string_scalar(const uint8_t* text) {
+    size_t length = 0;
+
+    while (text[length] != '"' && text[length] != '\\' && text[length] != '\n' && text[length] != '\0' &&
+           text[length] != 0xFF)
+        length++;
+
+    return length;
+}
+
+static size_t scan_until_scalar(const uint8_t* text, uint8_t first_stop, uint8_t second_stop) {
+    size_t length = 0;
+
+    while (text[length] != first_stop && text[length] != second_stop && text[length] != 0xFF)
+        length++;
+
+    return length;
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse2")))
+static size_t scan_whitespace_sse2(const uint8_t* text) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i control_range = _mm_set1_epi8('\r' - '\t');
+
+    size_t length = 0;
+
+    while (1) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + length));
+
+        // '\t' <= c <= '\r' as an unsigned compare: min(c - '\t', 4) == c - '\t'
+        __m128i control = _mm_sub_epi8(block, tab);
+        control = _mm_cmpeq_epi8(_mm_min_epu8(control, control_range), control);
+
+        __m128i whitespace = _mm_or_si128(control, _mm_cmpeq_epi8(block, space));
+        uint32_t whitespace_mask = (uint32_t)_mm_movemask_epi8(whitespace);
+
+        if (whitespace_mask != 0xFFFF)
+            return length + __builtin_ctz(~whitespace_mask);
+
+        length += 16;
+    }
+}
+
+__attribute__((target("sse2")))
+static size_t scan_newlines_sse2(const uint8_t* text, size_t length) {
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    size_t newlines = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+        newlines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    }
+
+    return newlines + scan_newlines_scalar(text + i, length - i);
+}
+
+__attribute__((target("sse2")))
+static size_t scan_string_sse2(const uint8_t* text) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sentinel = _mm_set1_epi8((char)0xFF);
+
+    size_t length = 0;
+
+    while (1) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + length));
+
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash));
+        stop = _mm_or_si128(stop, _mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, zero)));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(block, sentinel));
+
+        uint32_t stop_mask = (uint32_t)_mm_movemask_epi8(stop);
+
+        if (stop_mask != 0)
+            return length + __builtin_ctz(stop_mask);
+
+        length += 16;
+    }
+}
+
+__attribute__((target("sse2")))
+static size_t scan_until_sse2(const uint8_t* text, uint8_t first_stop, uint8_t second_stop) {
+    const __m128i first = _mm_set1_epi8((char)first_stop);
+    const __m128i second = _mm_set1_epi8((char)second_stop);
+    const __m128i sentinel = _mm_set1_epi8((char)0xFF);
+
+    size_t length = 0;
+
+    while (1) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + length));
+
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(block, sentinel));
+
+        uint32_t stop_mask = (uint32_t)_mm_movemask_epi8(stop);
+
+        if (stop_mask != 0)
+            return length + __builtin_ctz(stop_mask);
+
+        length += 16;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t scan_whitespace_avx2(const uint8_t* text) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i control_range = _mm256_set1_epi8('\r' - '\t');
+
+    size_t length = 0;
+
+    while (1) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + length));
+
+        __m256i control = _mm256_sub_epi8(block, tab);
+        control = _mm256_cmpeq_epi8(_mm256_min_epu8(control, control_range), control);
+
+        __m256i whitespace = _mm256_or_si256(control, _mm256_cmpeq_epi8(block, space));
+        uint32_t whitespace_mask = (uint32_t)_mm256_movemask_epi8(whitespace);
+
+        if (whitespace_mask != 0xFFFFFFFF)
+            return length + __builtin_ctz(~whitespace_mask);
+
+        length += 32;
+    }
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t scan_newlines_avx2(const uint8_t* text, size_t length) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    size_t newlines = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + i));
+        newlines += __builtin_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+    }
+
+    return newlines + scan_newlines_scalar(text + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_string_avx2(const uint8_t* text) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i sentinel = _mm256_set1_epi8((char)0xFF);
+
+    size_t length = 0;
+
+    while (1) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + length));
+
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash));
+        stop = _mm256_or_si256(stop, _mm256_or_si256(_mm256_cmpeq_epi8(block, newline), _mm256_cmpeq_epi8(block, zero)));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(block, sentinel));
+
+        uint32_t stop_mask = (uint32_t)_mm256_movemask_epi8(stop);
+
+        if (stop_mask != 0)
+            return length + __builtin_ctz(stop_mask);
+
+        length += 32;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t scan_until_avx2(const uint8_t* text, uint8_t first_stop, uint8_t second_stop) {
+    const __m256i first = _mm256_set1_epi8((char)first_stop);
+    const __m256i second = _mm256_set1_epi8((char)second_stop);
+    const __m256i sentinel = _mm256_set1_epi8((char)0xFF);
+
+    size_t length = 0;
+
+    while (1) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + length));
+
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(block, first), _mm256_cmpeq_epi8(block, second));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(block, sentinel));
+
+        uint32_t stop_mask = (uint32_t)_mm256_movemask_epi8(stop);
+
+        if (stop_mask != 0)
+            return length + __builtin_ctz(stop_mask);
+
+        length += 32;
+    }
+}
+
+#endif
+
+/**
+ * @brief Points every scanner to the best implementation supported by this CPU.
+ */
+static void scan_resolve(void) {
+    ScanWhitespaceFn whitespace = scan_whitespace_scalar;
+    ScanNewlinesFn newlines = scan_newlines_scalar;
+    ScanStringFn string = scan_string_scalar;
+    ScanUntilFn until = scan_until_scalar;
+
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        whitespace = scan_whitespace_avx2;
+        newlines = scan_newlines_avx2;
+        string = scan_string_avx2;
+        until = scan_until_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        whitespace = scan_whitespace_sse2;
+        newlines = scan_newlines_sse2;
+        string = scan_string_sse2;
+        until = scan_until_sse2;
+    }
+#endif
+
+    SCAN_STORE(scan_whitespace_impl, whitespace);
+    SCAN_STORE(scan_newlines_impl, newlines);
+    SCAN_STORE(scan_string_impl, string);
+    SCAN_STORE(scan_until_impl, until);
+}
+
+static size_t scan_whitespace_resolve(const uint8_t* text) {
+    scan_resolve();
+    return SCAN_LOAD(scan_whitespace_impl)(text);
+}
+
+static size_t scan_newlines_resolve(const uint8_t* text, size_t length) {
+    scan_resolve();
+    return SCAN_LOAD(scan_newlines_impl)(text, length);
+}
+
+static size_t scan_string_resolve(const uint8_t* text) {
+    scan_resolve();
+    return SCAN_LOAD(scan_string_impl)(text);
+}
+
+static size_t scan_until_resolve(const uint8_t* text, uint8_t first_stop, uint8_t second_stop) {
+    scan_resolve();
+    return SCAN_LOAD(scan_until_impl)(text, first_stop, second_stop);
+}
+
+size_t scan_whitespace(const uint8_t* text) {
+    return SCAN_LOAD(scan_whitespace_impl)(text);
+}
+
+size_t scan_newlines(const uint8_t* text, size_t length) {
+    return SCAN_LOAD(scan_newlines_impl)(text, length);
+}
+
+size_t scan_string(const uint8_t* text) {
+    return SCAN_LOAD(scan_string_impl)(text);
+}
+
+size_t scan_until(const uint8_t* text, uint8_t first_stop, uint8_t second_stop) {
+    return SCAN_LOAD(scan_until_impl)(text, first_stop, second_stop);
+}
@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbol.h"
+
+// Odd constant with well spread bits (2^64 / golden ratio)
+#define SYMBOL_HASH_MULTIPLIER      0x9E3779B97F4A7C15ULL
+
+static inline uint64_t mix(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * SYMBOL_HASH_MULTIPLIER;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * @brief Hashes a name 8 bytes at a time.
+ * 
+ * @param text Name, doesn't need to be null terminated.
+ * @param size Size of text.
+ * @return Hash of the name.
+ */
+uint64_t symbol_hash(const char* text, size_t size) {
+    uint64_t hash = size * SYMBOL_HASH_MULTIPLIER;
+
+    for (; size >= 8; text += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, text, 8);
+        hash = mix(hash, word);
+    }
+
+    if (size > 0) {
+        uint64_t word = 0;
+        memcpy(&word, text, size);
+        hash = mix(hash, word);
+    }
+
+    return mix(hash, 0);
+}
+
+/**
+ * @brief Doubles the hash index (or creates it) and puts every symbol back in it.
+ * 
+ * @param table Symbol table.
+ * @return 1 on success, 0 if out of memory (the index stays the same).
+ */
+static int grow_slots(SymbolTable* table) {
+    size_t slot_count = table->slot_count == 0 ? SYMBOL_TABLE_MIN_SLOTS : table->slot_count * 2;
+    SymbolSlot* slots = calloc(slot_count, sizeof(SymbolSlot));
+
+    if (slots == NULL)
+        return 0;
+
+    for (uint32_t id = 0; id < table->count; id++) {
+        uint64_t hash = table->symbols[id].hash;
+        size_t i = hash & (slot_count - 1);
+
+        while (slots[i].id != 0)
+            i = (i + 1) & (slot_count - 1);
+
+        slots[i] = (SymbolSlot){.tag = hash >> 32, .id = id + 1};
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->slot_count = slot_count;
+    return 1;
+}
+
+/**
+ * @brief Finds the id of a name, adding it to the table the first time it's seen.
+ * 
+ * @param table Symbol table.
+ * @param arena Receives a copy of new names. If NULL, new names are kept as given and must outlive the table.
+ * @param text Name, doesn't need to be null terminated.
+ * @param size Size of text.
+ * @param hash symbol_hash of the name.
+ * @return Id of the name, TOKEN_NO_SYMBOL if out of memory.
+ */
+uint32_t symbol_intern(SymbolTable* table, Arena* arena, const char* text, size_t size, uint64_t hash) {
+    if (2 * ((size_t)table->count + 1) > table->slot_count && !grow_slots(table)) {
+        table->failed = 1;
+        return TOKEN_NO_SYMBOL;
+    }
+
+    size_t mask = table->slot_count - 1;
+    uint32_t tag = hash >> 32;
+    size_t i = hash & mask;
+
+    for (; table->slots[i].id != 0; i = (i + 1) & mask) {
+        const Symbol* symbol = &table->symbols[table->slots[i].id - 1];
+
+        if (table->slots[i].tag == tag && symbol->size == size && memcmp(symbol->text, text, size) == 0)
+            return table->slots[i].id - 1;
+    }
+
+    if (table->count == table->capacity) {
+        uint32_t capacity = table->capacity == 0 ? SYMBOL_TABLE_MIN_SLOTS / 2 : table->capacity * 2;
+        Symbol* symbols = realloc(table->symbols, capacity * sizeof(Symbol));
+
+        if (symbols == NULL) {
+            table->failed = 1;
+            return TOKEN_NO_SYMBOL;
+        }
+
+        table->symbols = symbols;
+        table->capacity = capacity;
+    }
+
+    if (arena != NULL) {
+        char* copy = arena_alloc(arena, size);
+
+        if (copy == NULL) {
+            table->failed = 1;
+            return TOKEN_NO_SYMBOL;
+        }
+
+        memcpy(copy, text, size);
+        text = copy;
+    }
+
+    uint32_t id = table->count++;
+
+    table->symbols[id] = (Symbol){.text = text, .size = size, .hash = hash};
+    table->slots[i] = (SymbolSlot){.tag = tag, .id = id + 1};
+    return id;
+}
+
+/**
+ * @brief Frees the table, leaving it empty. The copied names belong to the arena given to symbol_intern.
+ * 
+ * @param table Symbol table.
+ */
+void symbol_table_free(SymbolTable* table) {
+    free(table->slots);
+    free(table->symbols);
+    *table = (SymbolTable){0};
+}
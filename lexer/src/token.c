@@ -0,0 +1,63 @@
+#include "token.h"
+
+// Kind and name of every token, expanded once for each table below
+#define TOKEN_KIND_LIST(X) \
+    X(TOKEN_NONE, "none") \
+    X(TOKEN_EOF, "eof") \
+    \
+    X(TOKEN_IDENTIFIER, "identifier") \
+    X(TOKEN_TYPE, "type") \
+    X(TOKEN_INTEGER, "integer") \
+    X(TOKEN_STRING, "string") \
+    X(TOKEN_ERROR, "error") \
+    \
+    X(TOKEN_CLASS, "class") \
+    X(TOKEN_ELSE, "else") \
+    X(TOKEN_FALSE, "false") \
+    X(TOKEN_FI, "fi") \
+    X(TOKEN_IF, "if") \
+    X(TOKEN_IN, "in") \
+    X(TOKEN_INHERITS, "inherits") \
+    X(TOKEN_ISVOID, "isvoid") \
+    X(TOKEN_LET, "let") \
+    X(TOKEN_LOOP, "loop") \
+    X(TOKEN_POOL, "pool") \
+    X(TOKEN_THEN, "then") \
+    X(TOKEN_WHILE, "while") \
+    X(TOKEN_CASE, "case") \
+    X(TOKEN_ESAC, "esac") \
+    X(TOKEN_NEW, "new") \
+    X(TOKEN_OF, "of") \
+    X(TOKEN_NOT, "not") \
+    X(TOKEN_TRUE, "true") \
+    \
+    X(TOKEN_LPAREN, "lparen") \
+    X(TOKEN_RPAREN, "rparen") \
+    X(TOKEN_TIMES, "times") \
+    X(TOKEN_PLUS, "plus") \
+    X(TOKEN_COMMA, "comma") \
+    X(TOKEN_MINUS, "minus") \
+    X(TOKEN_DOT, "dot") \
+    X(TOKEN_DIVIDE, "divide") \
+    X(TOKEN_COLON, "colon") \
+    X(TOKEN_SEMI, "semi") \
+    X(TOKEN_LARROW, "larrow") \
+    X(TOKEN_LE, "le") \
+    X(TOKEN_LT, "lt") \
+    X(TOKEN_RARROW, "rarrow") \
+    X(TOKEN_EQUALS, "equals") \
+    X(TOKEN_AT, "at") \
+    X(TOKEN_LBRACE, "lbrace") \
+    X(TOKEN_RBRACE, "rbrace") \
+    X(TOKEN_TILDE, "tilde")
+
+#define TOKEN_NAME(_KIND, _NAME)        [_KIND] = _NAME,
+#define TOKEN_NAME_SIZE(_KIND, _NAME)   [_KIND] = sizeof(_NAME) - 1,
+
+const char* const token_kind_names[TOKEN_KIND_COUNT] = {
+    TOKEN_KIND_LIST(TOKEN_NAME)
+};
+
+const uint8_t token_kind_name_sizes[TOKEN_KIND_COUNT] = {
+    TOKEN_KIND_LIST(TOKEN_NAME_SIZE)
+};
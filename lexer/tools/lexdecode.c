@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_reader.h"
+#include "lexer.h"
+#include "output.h"
+#include "token.h"
+
+/**
+ * @brief Reads the whole file into memory.
+ * 
+ * @param filename File to read.
+ * @param size Receives the file size.
+ * @return Allocated contents, or NULL on error.
+ */
+uint8_t* read_whole_file(const char* filename, size_t* size) {
+    FILE* fp = fopen(filename, "rb");
+
+    if (fp == NULL)
+        return NULL;
+
+    size_t capacity = 64 * 1024;
+    uint8_t* data = malloc(capacity);
+    *size = 0;
+
+    while (data != NULL) {
+        *size += fread(data + *size, 1, capacity - *size, fp);
+
+        if (*size < capacity)
+            break;
+
+        capacity *= 2;
+        uint8_t* bigger = realloc(data, capacity);
+
+        if (bigger == NULL)
+            free(data);
+
+        data = bigger;
+    }
+
+    if (ferror(fp)) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(fp);
+    return data;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("\33[31mERROR:\33[0m expected usage: %s [binary tokens file] [text output file]\n", argv[0]);
+        return LEXER_ERROR_INCORRECT_USAGE;
+    }
+
+    size_t size;
+    uint8_t* data = read_whole_file(argv[1], &size);
+
+    if (data == NULL) {
+        printf("\33[31mERROR:\33[0m could not read file %s\n", argv[1]);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    BinaryReader reader;
+
+    if (!binary_reader_init(&reader, data, size)) {
+        printf("\33[31mERROR:\33[0m %s is not a binary tokens file (version %d)\n", argv[1], BINARY_VERSION);
+        free(data);
+        return LEXER_ERROR_MALFORMED_BINARY;
+    }
+
+    OutputBuffer* out = output_open(argv[2]);
+
+    if (out == NULL) {
+        printf("\33[31mERROR:\33[0m could not open output file %s\n", argv[2]);
+        free(data);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    Token token;
+    const char* text;
+    size_t text_size;
+    int status;
+
+    while ((status = binary_read_token(&reader, &token, &text, &text_size)) == 1)
+        write_token_text(out, &token, text, text_size);
+
+    int written = output_close(out);
+    binary_reader_free(&reader);
+    free(data);
+
+    if (status < 0) {
+        printf("\33[31mERROR:\33[0m %s is truncated or corrupted\n", argv[1]);
+        return LEXER_ERROR_MALFORMED_BINARY;
+    }
+
+    if (!written) {
+        printf("\33[31mERROR:\33[0m could not write output file %s\n", argv[2]);
+        return LEXER_ERROR_FILE_IO;
+    }
+
+    return LEXER_OK;
+}